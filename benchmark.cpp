@@ -0,0 +1,141 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+#include "benchmark.h"
+#include "model.h"
+#include "level.h"
+#include "creature.h"
+#include "creature_factory.h"
+#include "collective.h"
+#include "player_control.h"
+#include "monster.h"
+#include "task.h"
+#include "tribe.h"
+
+#ifndef WINDOWS
+#include <sys/resource.h>
+#endif
+
+static const vector<pair<string, Benchmark::Scenario>> scenarioNames {
+  {"early_keeper", Benchmark::Scenario::EARLY_KEEPER},
+  {"minions100", Benchmark::Scenario::KEEPER_MINIONS},
+  {"village_siege", Benchmark::Scenario::VILLAGE_SIEGE},
+  {"adventurer", Benchmark::Scenario::ADVENTURER},
+};
+
+Optional<Benchmark::Scenario> Benchmark::getScenario(const string& name) {
+  for (auto& elem : scenarioNames)
+    if (elem.first == name)
+      return elem.second;
+  return Nothing();
+}
+
+void Benchmark::addMinions(Model* model, int num) {
+  Collective* collective = NOTNULL(model->playerCollective);
+  Level* level = collective->getLevel();
+  vector<CreatureId> ids {CreatureId::GOBLIN, CreatureId::ORC, CreatureId::OGRE};
+  for (int i : Range(num)) {
+    PCreature c = CreatureFactory::fromId(ids[i % ids.size()], Tribe::get(TribeId::KEEPER),
+        MonsterAIFactory::collective(collective));
+    Creature* ref = c.get();
+    level->landCreature(StairDirection::UP, StairKey::PLAYER_SPAWN, ref);
+    model->addCreature(std::move(c));
+    collective->addCreature(ref, {MinionTrait::FIGHTER});
+  }
+}
+
+/** Sends all fighters of every main villain at the keeper at once, instead of waiting for the attack
+    triggers in VillageControl.*/
+void Benchmark::launchVillainAttacks(Model* model) {
+  Collective* victim = NOTNULL(model->playerCollective);
+  for (Collective* villain : model->mainVillains) {
+    vector<Creature*> attackers = villain->getCreatures({MinionTrait::FIGHTER}, {MinionTrait::LEADER});
+    if (attackers.empty())
+      continue;
+    villain->getTeams().activate(villain->getTeams().create(attackers));
+    for (Creature* c : attackers)
+      villain->setTask(c, Task::attackLeader(victim));
+  }
+}
+
+void Benchmark::setup(Model* model, Scenario scenario) {
+  model->recordHighscores = false;
+  switch (scenario) {
+    case Scenario::EARLY_KEEPER:
+      break;
+    case Scenario::KEEPER_MINIONS:
+      addMinions(model, 100);
+      break;
+    case Scenario::VILLAGE_SIEGE:
+      addMinions(model, 30);
+      launchVillainAttacks(model);
+      break;
+    case Scenario::ADVENTURER:
+      if (model->playerControl && !model->playerControl->isRetired())
+        model->retireCollective();
+      break;
+  }
+  if (model->addHero) {
+    model->landHeroPlayer();
+    model->addHero = false;
+  }
+  if (const Creature* player = model->getPlayer()) {
+    Creature* c = const_cast<Creature*>(player);
+    c->setController(PController(new Monster(c, MonsterAIFactory::monster())));
+  }
+}
+
+static string getPeakMemory() {
+#ifdef WINDOWS
+  return "unknown";
+#else
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef OSX
+  return toString(int(usage.ru_maxrss / 1024 / 1024)) + " MB";
+#else
+  return toString(int(usage.ru_maxrss / 1024)) + " MB";
+#endif
+#endif
+}
+
+static double getPercentile(const vector<double>& sorted, double p) {
+  return sorted[min<int>(sorted.size() - 1, sorted.size() * p)];
+}
+
+void Benchmark::run(Model* model, int numTurns, std::ostream& out) {
+  CHECK(numTurns > 0);
+  typedef std::chrono::steady_clock Clock;
+  vector<double> turnMillis;
+  double totalTime = model->getTime();
+  Clock::time_point begin = Clock::now();
+  for (int i : Range(numTurns)) {
+    Clock::time_point turnBegin = Clock::now();
+    bool exit = !!model->update(++totalTime);
+    turnMillis.push_back(std::chrono::duration<double, std::milli>(Clock::now() - turnBegin).count());
+    if (exit) {
+      out << "Game ended after " << i + 1 << " turns" << endl;
+      break;
+    }
+  }
+  double totalMillis = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+  std::sort(turnMillis.begin(), turnMillis.end());
+  out << "Simulated " << turnMillis.size() << " turns in " << int(totalMillis) << " ms, "
+    << turnMillis.size() * 1000 / totalMillis << " turns/s" << endl;
+  out << "Turn time p50 " << getPercentile(turnMillis, 0.5) << " ms, p99 " << getPercentile(turnMillis, 0.99)
+    << " ms, max " << turnMillis.back() << " ms" << endl;
+  out << "Peak memory " << getPeakMemory() << endl;
+}
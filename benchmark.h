@@ -0,0 +1,51 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+#include "util.h"
+
+class Model;
+
+/** Runs the simulation headless for a fixed number of turns and reports its speed. Together with a fixed seed
+    the scenarios make reproducible regression benchmarks, see the bench target in the Makefile.*/
+class Benchmark {
+  public:
+  enum class Scenario {
+    EARLY_KEEPER,
+    KEEPER_MINIONS,
+    VILLAGE_SIEGE,
+    ADVENTURER,
+  };
+
+  /** Returns the scenario with the given command line name.*/
+  static Optional<Scenario> getScenario(const string& name);
+
+  /** Prepares a freshly generated or loaded model for the scenario. The model's view should be a NullView.
+      Nothing ever gives the player any input, so the player character, if there is one, is driven by the
+      monster AI and the keeper is left to the collective AI. Highscores are not recorded.*/
+  static void setup(Model*, Scenario);
+
+  /** Advances the model turn by turn and prints turns per second, latency of a turn and peak memory usage.
+      Stops early if the game ends.*/
+  static void run(Model*, int numTurns, std::ostream&);
+
+  private:
+  static void addMinions(Model*, int num);
+  static void launchVillainAttacks(Model*);
+};
+
+#endif
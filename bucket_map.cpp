@@ -2,38 +2,47 @@
 #include "bucket_map.h"
 #include "creature.h"
 
-template <class T>
-template <class Archive>
-void BucketMap<T>::serialize(Archive& ar, const unsigned int version) {
-  ar& SVAR(bucketSize)
-    & SVAR(buckets);
-  CHECK_SERIAL;
+template<class T>
+BucketMap<T>::BucketMap(int w, int h, int size)
+    : bucketSize(size), width((w + size - 1) / size), height((h + size - 1) / size), buckets(width * height) {
 }
 
-SERIALIZABLE(BucketMap<Creature*>);
-
-template <class T>
-SERIALIZATION_CONSTRUCTOR_IMPL2(BucketMap<T>, BucketMap);
-
 template<class T>
-BucketMap<T>::BucketMap(int w, int h, int size)
-    : bucketSize(size), buckets((w + size - 1) / size, (h + size - 1) / size) {
+vector<pair<Vec2, T>>& BucketMap<T>::getBucket(Vec2 v) {
+  return buckets[v.x / bucketSize + (v.y / bucketSize) * width];
 }
 
 template<class T>
 void BucketMap<T>::addElement(Vec2 v, T elem) {
-  CHECK(!buckets[v.x / bucketSize][v.y / bucketSize].count(elem));
-  buckets[v.x / bucketSize][v.y / bucketSize].insert(elem);
+  vector<pair<Vec2, T>>& bucket = getBucket(v);
+  CHECK(std::find_if(bucket.begin(), bucket.end(),
+        [elem](const pair<Vec2, T>& e) { return e.second == elem; }) == bucket.end());
+  bucket.emplace_back(v, elem);
 }
 
 template<class T>
 void BucketMap<T>::removeElement(Vec2 v, T elem) {
-  CHECK(buckets[v.x / bucketSize][v.y / bucketSize].count(elem));
-  buckets[v.x / bucketSize][v.y / bucketSize].erase(elem);
+  vector<pair<Vec2, T>>& bucket = getBucket(v);
+  for (auto& e : bucket)
+    if (e.second == elem) {
+      e = bucket.back();
+      bucket.pop_back();
+      return;
+    }
+  FAIL << "Element not found " << v;
 }
 
 template<class T>
 void BucketMap<T>::moveElement(Vec2 from, Vec2 to, T elem) {
+  vector<pair<Vec2, T>>& bucket = getBucket(from);
+  if (&bucket == &getBucket(to)) {
+    for (auto& e : bucket)
+      if (e.second == elem) {
+        e.first = to;
+        return;
+      }
+    FAIL << "Element not found " << from;
+  }
   removeElement(from, elem);
   addElement(to, elem);
 }
@@ -41,13 +50,50 @@ void BucketMap<T>::moveElement(Vec2 from, Vec2 to, T elem) {
 template<class T>
 vector<T> BucketMap<T>::getElements(Rectangle area) const {
   vector<T> ret;
-  Rectangle allBuckets = Rectangle(
-      area.getPX() / bucketSize, area.getPY() / bucketSize,
-      area.getKX() / bucketSize, area.getKY() / bucketSize)
-    .intersection(Rectangle(buckets.getBounds()));
-  for (Vec2 v : allBuckets)
-    for (T elem : buckets[v])
-      ret.push_back(elem);
+  visit(area, [&ret] (T elem) { ret.push_back(elem); });
+  return ret;
+}
+
+template<class T>
+vector<T> BucketMap<T>::getNearest(Vec2 center, int maxDist, int num, function<bool(T)> predicate) const {
+  vector<T> ret;
+  Vec2 centerBucket(center.x / bucketSize, center.y / bucketSize);
+  // Elements that were found but can't be checked yet, because the next rings may hold closer ones.
+  vector<pair<int, T>> pending;
+  auto addBucket = [&] (Vec2 v) {
+    if (v.x >= 0 && v.y >= 0 && v.x < width && v.y < height)
+      for (auto& elem : buckets[v.x + v.y * width]) {
+        int dist = (elem.first - center).length8();
+        if (dist <= maxDist)
+          pending.emplace_back(dist, elem.second);
+      }
+  };
+  for (int ring = 0; ring <= maxDist / bucketSize + 1 && ret.size() < num; ++ring) {
+    if (ring == 0)
+      addBucket(centerBucket);
+    for (int i = -ring; i <= ring && ring > 0; ++i) {
+      addBucket(centerBucket + Vec2(i, -ring));
+      addBucket(centerBucket + Vec2(i, ring));
+      if (i > -ring && i < ring) {
+        addBucket(centerBucket + Vec2(-ring, i));
+        addBucket(centerBucket + Vec2(ring, i));
+      }
+    }
+    // All elements in further rings are at least this far.
+    Vec2 visitedStart = (centerBucket - Vec2(ring, ring)) * bucketSize;
+    Vec2 visitedEnd = (centerBucket + Vec2(ring + 1, ring + 1)) * bucketSize;
+    int minDist = 1 + min(min(center.x - visitedStart.x, visitedEnd.x - 1 - center.x),
+        min(center.y - visitedStart.y, visitedEnd.y - 1 - center.y));
+    std::stable_sort(pending.begin(), pending.end(),
+        [] (const pair<int, T>& a, const pair<int, T>& b) { return a.first < b.first; });
+    int checked = 0;
+    while (checked < pending.size() && pending[checked].first < minDist && ret.size() < num) {
+      if (predicate(pending[checked].second))
+        ret.push_back(pending[checked].second);
+      ++checked;
+    }
+    pending.erase(pending.begin(), pending.begin() + checked);
+  }
   return ret;
 }
 
@@ -1,7 +1,10 @@
 #ifndef _BUCKET_MAP_H
+#define _BUCKET_MAP_H
 
 #include "util.h"
 
+/** Spatial index of elements on a map. The map is split into square buckets, each holding a short
+    vector of its elements together with their positions.*/
 template <typename T>
 class BucketMap {
   public:
@@ -13,11 +16,35 @@ class BucketMap {
 
   vector<T> getElements(Rectangle area) const;
 
-  SERIALIZATION_DECL(BucketMap);
+  /** Calls \paramname{fun} on every element inside the area, without allocating.*/
+  template <typename Fun>
+  void visit(Rectangle area, Fun fun) const {
+    visitWithPositions(area, [&fun] (Vec2, T elem) { fun(elem); });
+  }
+
+  /** Returns up to \paramname{num} elements within \paramname{maxDist} (in length8) that satisfy the
+      predicate, closest first. Buckets are visited in rings around the center and the predicate is only
+      evaluated until enough elements are found, so a close match doesn't require scanning the whole area.*/
+  vector<T> getNearest(Vec2 center, int maxDist, int num, function<bool(T)> predicate) const;
 
   private:
-  int SERIAL(bucketSize);
-  Table<unordered_set<T>> SERIAL(buckets);
+  template <typename Fun>
+  void visitWithPositions(Rectangle area, Fun fun) const {
+    Rectangle allBuckets = Rectangle(
+        area.getPX() / bucketSize, area.getPY() / bucketSize,
+        (area.getKX() + bucketSize - 1) / bucketSize, (area.getKY() + bucketSize - 1) / bucketSize)
+      .intersection(Rectangle(width, height));
+    for (Vec2 v : allBuckets)
+      for (auto& elem : buckets[v.x + v.y * width])
+        if (elem.first.inRectangle(area))
+          fun(elem.first, elem.second);
+  }
+
+  vector<pair<Vec2, T>>& getBucket(Vec2);
+  int bucketSize;
+  int width;
+  int height;
+  vector<vector<pair<Vec2, T>>> buckets;
 };
 
 #endif
@@ -9,3 +9,10 @@ if [ "$?" != "0" ]; then
   exit 1
 fi
 
+grep -o "TRANSIENT(\w*)" *.{h,cpp} | grep -v "serialization\." | cut -d"(" -f 2 | cut -d")" -f 1 | sort > /tmp/transient
+if [ -n "$(comm -12 /tmp/transient /tmp/def)" ]; then
+  comm -12 /tmp/transient /tmp/def
+  echo "======== Transient member is serialized ========"
+  exit 1
+fi
+
@@ -350,10 +350,16 @@ void Collective::onBedCreated(Vec2 pos, SquareType fromType, SquareType toType)
   changeSquareType(pos, fromType, toType);
 }
 
+Collective::CostInfo Collective::removeTask(Task* task) {
+  if (auto pos = taskMap.getPosition(task))
+    getLevel()->markChanged(*pos);
+  return taskMap.removeTask(task);
+}
+
 MoveInfo Collective::getWorkerMove(Creature* c) {
   if (Task* task = taskMap.getTask(c)) {
     if (task->isDone()) {
-      taskMap.removeTask(task);
+      removeTask(task);
     } else
       return task->getMove(c);
   }
@@ -576,7 +582,7 @@ void Collective::setTask(const Creature *c, PTask task) {
   if (Task* task = taskMap.getTask(c)) {
     if (!task->canTransfer()) {
       task->cancel();
-      returnResource(taskMap.removeTask(task));
+      returnResource(removeTask(task));
     } else
       taskMap.freeTaskDelay(task, getTime() + 50);
   }
@@ -595,7 +601,7 @@ MoveInfo Collective::getMove(Creature* c) {
   if (Task* task = taskMap.getTask(c))
     if (taskMap.isPriorityTask(task)) {
       if (task->isDone()) {
-        taskMap.removeTask(task);
+        removeTask(task);
       } else
         return task->getMove(c);
     }
@@ -616,7 +622,7 @@ MoveInfo Collective::getMove(Creature* c) {
   }
   if (Task* task = taskMap.getTask(c)) {
     if (task->isDone()) {
-      taskMap.removeTask(task);
+      removeTask(task);
     } else
       return task->getMove(c);
   }
@@ -773,7 +779,7 @@ vector<Vec2> Collective::getSpawnPos(const vector<Creature*>& creatures) {
       pos = chooseRandom(extendedTiles);
     } while ((!getLevel()->getSafeSquare(pos)->canEnter(c) || contains(spawnPos, pos)) && --cnt > 0);
     if (cnt == 0) {
-      Debug() << "Couldn't spawn immigrant " << c->getName().bare();
+      LOG(INFO, COLLECTIVE) << "Couldn't spawn immigrant " << c->getName().bare();
       return {};
     } else
       spawnPos.push_back(pos);
@@ -889,7 +895,7 @@ bool Collective::considerImmigrant(const ImmigrantInfo& info) {
     addCreature(std::move(creatures[i]), spawnPos[i], info.traits);
     if (bedType) {
       taskMap.addPriorityTask(Task::createBed(this, bedPos[i], dormType, *bedType), c);
-      Debug() << c->getName().bare() << " creating bed " << bedPos[i];
+      LOG(INFO, COLLECTIVE) << c->getName().bare() << " creating bed " << bedPos[i];
     }
     minionPayment[c] = {info.salary, 0.0, 0};
     minionAttraction[c] = info.attractions;
@@ -1062,17 +1068,28 @@ void Collective::considerWeaponWarning() {
 }
 
 void Collective::tick(double time) {
-  control->tick(time);
-  considerHealingLeader();
-  considerBirths();
-  if (Random.rollD(1.0 / config.getImmigrantFrequency()))
-    considerImmigration();
-  if (nextPayoutTime > -1 && time > nextPayoutTime) {
-    nextPayoutTime += config.getPayoutTime();
-    makePayouts();
-  }
-  cashPayouts();
+  PROFILE_ZONE("Collective::tick");
+  {
+    PROFILE_ZONE("collective control");
+    control->tick(time);
+  }
+  {
+    PROFILE_ZONE("collective births");
+    considerHealingLeader();
+    considerBirths();
+    if (Random.rollD(1.0 / config.getImmigrantFrequency()))
+      considerImmigration();
+  }
+  {
+    PROFILE_ZONE("collective payouts");
+    if (nextPayoutTime > -1 && time > nextPayoutTime) {
+      nextPayoutTime += config.getPayoutTime();
+      makePayouts();
+    }
+    cashPayouts();
+  }
   if (config.getWarnings()) {
+    PROFILE_ZONE("collective warnings");
     considerWeaponWarning();
     setWarning(Warning::MANA, numResource(ResourceId::MANA) < 100);
     setWarning(Warning::DIGGING, getSquares(SquareId::FLOOR).empty());
@@ -1087,6 +1104,7 @@ void Collective::tick(double time) {
         setWarning(*elem.second.warning, false);
   }
   if (config.getEnemyPositions()) {
+    PROFILE_ZONE("collective enemies");
     vector<Vec2> enemyPos = getEnemyPositions();
     if (alarmInfo.finishTime() > 0) {
       if (!enemyPos.empty())
@@ -1115,9 +1133,12 @@ void Collective::tick(double time) {
         }
     }
   }
-  if (config.getConstructions())
+  if (config.getConstructions()) {
+    PROFILE_ZONE("collective constructions");
     updateConstructions();
-  if (config.getFetchItems())
+  }
+  if (config.getFetchItems()) {
+    PROFILE_ZONE("collective fetch items");
     for (const ItemFetchInfo& elem : getFetchInfo()) {
       for (Vec2 pos : getAllSquares())
         fetchItems(pos, elem);
@@ -1125,8 +1146,11 @@ void Collective::tick(double time) {
         for (Vec2 pos : getSquares(type))
           fetchItems(pos, elem);
     }
-  if (config.getManageEquipment())
+  }
+  if (config.getManageEquipment()) {
+    PROFILE_ZONE("collective equipment");
     minionEquipment.updateOwners(getAllItems([](const Item*) { return true;}, true));
+  }
 }
 
 const vector<Creature*>& Collective::getCreatures(MinionTrait trait) const {
@@ -1222,7 +1246,7 @@ void Collective::onKillEvent(const Creature* victim1, const Creature* killer) {
     if (Task* task = taskMap.getTask(victim)) {
       if (!task->canTransfer()) {
         task->cancel();
-        returnResource(taskMap.removeTask(task));
+        returnResource(removeTask(task));
       } else
         taskMap.freeTaskDelay(task, getTime() + 50);
     }
@@ -1354,11 +1378,14 @@ const set<Vec2>& Collective::getAllSquares() const {
 
 void Collective::claimSquare(Vec2 pos) {
   allSquares.insert(pos);
+  getLevel()->markChanged(pos);
 }
 
 void Collective::changeSquareType(Vec2 pos, SquareType from, SquareType to) {
   mySquares[from].erase(pos);
   mySquares[to].insert(pos);
+  destinationChanged(from);
+  destinationChanged(to);
 }
 
 bool Collective::containsSquare(Vec2 pos) const {
@@ -1415,6 +1442,7 @@ void Collective::updateEfficiency(Vec2 pos, SquareType type) {
         CHECK(squareEfficiency[v] >=0);
       }
   }
+  getLevel()->markChanged(Rectangle(pos - Vec2(1, 1), pos + Vec2(2, 2)));
 }
 
 static const int alarmTime = 100;
@@ -1470,10 +1498,12 @@ double Collective::getTime() const {
 
 void Collective::addGuardPost(Vec2 pos) {
   guardPosts[pos] = {};
+  getLevel()->markChanged(pos);
 }
 
 void Collective::removeGuardPost(Vec2 pos) {
   guardPosts.erase(pos);
+  getLevel()->markChanged(pos);
 }
 
 bool Collective::isGuardPost(Vec2 pos) const {
@@ -1670,11 +1700,13 @@ const map<Vec2, Collective::TrapInfo>& Collective::getTraps() const {
 
 void Collective::removeTrap(Vec2 pos) {
   traps.erase(pos);
+  getLevel()->markChanged(pos);
 }
 
 void Collective::removeConstruction(Vec2 pos) {
   returnResource(taskMap.removeTask(constructions.at(pos).task()));
   constructions.erase(pos);
+  getLevel()->markChanged(pos);
 }
 
 void Collective::destroySquare(Vec2 pos) {
@@ -1699,6 +1731,7 @@ void Collective::addConstruction(Vec2 pos, SquareType type, CostInfo cost, bool
     onConstructed(pos, type);
   } else if (!noCredit || hasResource(cost)) {
     constructions[pos] = {cost, false, 0, type, -1};
+    getLevel()->markChanged(pos);
     updateConstructions();
   }
 }
@@ -1709,10 +1742,12 @@ const map<Vec2, Collective::ConstructionInfo>& Collective::getConstructions() co
 
 void Collective::dig(Vec2 pos) {
   taskMap.markSquare(pos, Task::construction(this, pos, SquareId::FLOOR));
+  getLevel()->markChanged(pos);
 }
 
 void Collective::dontDig(Vec2 pos) {
   taskMap.unmarkSquare(pos);
+  getLevel()->markChanged(pos);
 }
 
 bool Collective::isMarkedToDig(Vec2 pos) const {
@@ -1721,6 +1756,7 @@ bool Collective::isMarkedToDig(Vec2 pos) const {
 
 void Collective::setPriorityTasks(Vec2 pos) {
   taskMap.setPriorityTasks(pos);
+  getLevel()->markChanged(pos);
 }
 
 bool Collective::hasPriorityTasks(Vec2 pos) const {
@@ -1729,6 +1765,7 @@ bool Collective::hasPriorityTasks(Vec2 pos) const {
 
 void Collective::cutTree(Vec2 pos) {
   taskMap.markSquare(pos, Task::construction(this, pos, SquareId::TREE_TRUNK));
+  getLevel()->markChanged(pos);
 }
 
 set<TrapType> Collective::getNeededTraps() const {
@@ -1741,6 +1778,7 @@ set<TrapType> Collective::getNeededTraps() const {
 
 void Collective::addTrap(Vec2 pos, TrapType type) {
   traps[pos] = {type, false, 0};
+  getLevel()->markChanged(pos);
   updateConstructions();
 }
 
@@ -1749,6 +1787,7 @@ void Collective::onAppliedItem(Vec2 pos, Item* item) {
   if (traps.count(pos)) {
     traps[pos].marked() = 0;
     traps[pos].armed() = true;
+    getLevel()->markChanged(pos);
   }
 }
 
@@ -1762,6 +1801,7 @@ void Collective::onTorchBuilt(Vec2 pos, Trigger* t) {
   torches.at(pos).marked() = 0;
   torches.at(pos).task() = -1;
   torches.at(pos).trigger() = t;
+  getLevel()->markChanged(pos);
 }
 
 void Collective::onConstructed(Vec2 pos, SquareType type) {
@@ -1769,14 +1809,17 @@ void Collective::onConstructed(Vec2 pos, SquareType type) {
     allSquares.insert(pos);
   CHECK(!getSquares(type).count(pos));
   for (auto& elem : mySquares)
-      elem.second.erase(pos);
+    if (elem.second.erase(pos))
+      destinationChanged(elem.first);
   mySquares[type].insert(pos);
+  destinationChanged(type);
   if (efficiencySquares.count(type))
     updateEfficiency(pos, type);
   if (contains({SquareId::FLOOR, SquareId::BRIDGE, SquareId::BARRICADE}, type.getId()))
     updateSectors(pos);
   if (taskMap.getMarked(pos))
     taskMap.unmarkSquare(pos);
+  getLevel()->markChanged(pos);
   if (constructions.count(pos)) {
     constructions.at(pos).built() = true;
     constructions.at(pos).marked() = 0;
@@ -1883,12 +1926,11 @@ void Collective::fetchItems(Vec2 pos, const ItemFetchInfo& elem, bool ignoreDela
       return;
   vector<Item*> equipment = getLevel()->getSafeSquare(pos)->getItems(elem.predicate);
   if (!equipment.empty()) {
-    vector<Vec2> destination = getAllSquares(elem.destination);
-    if (!destination.empty()) {
+    if (!getDestinationArea(elem.destination)->getSquares().empty()) {
       setWarning(elem.warning, false);
       if (elem.oneAtATime)
         equipment = {equipment[0]};
-      taskMap.addTask(Task::bringItem(this, pos, equipment, destination), pos);
+      taskMap.addTask(Task::bringItem(this, pos, equipment, elem.destination), pos);
       for (Item* it : equipment)
         markItem(it);
     } else
@@ -1896,6 +1938,21 @@ void Collective::fetchItems(Vec2 pos, const ItemFetchInfo& elem, bool ignoreDela
   }
 }
 
+const DestinationArea* Collective::getDestinationArea(const vector<SquareType>& types) {
+  for (auto& elem : destinationAreas)
+    if (elem.first == types)
+      return &elem.second;
+  destinationAreas.emplace_back(types, DestinationArea(getAllSquares(types)));
+  return &destinationAreas.back().second;
+}
+
+void Collective::destinationChanged(SquareType type) {
+  // The area is built again when it's next needed, and gets a new id, so the old flow fields aren't used.
+  for (int i = destinationAreas.size() - 1; i >= 0; --i)
+    if (contains(destinationAreas[i].first, type))
+      destinationAreas.erase(destinationAreas.begin() + i);
+}
+
 void Collective::onSurrenderEvent(Creature* who, const Creature* to) {
   if (contains(getCreatures(), to) && !contains(getCreatures(), who) && !prisonerInfo.count(who) && who->isHumanoid())
     prisonerInfo[who] = {PrisonerState::SURRENDER, 0};
@@ -1907,6 +1964,7 @@ void Collective::onSquareReplacedEvent(const Level* l, Vec2 pos) {
     for (auto& elem : mySquares)
       if (elem.second.count(pos)) {
         elem.second.erase(pos);
+        destinationChanged(elem.first);
         if (efficiencySquares.count(elem.first))
           updateEfficiency(pos, elem.first);
       }
@@ -1915,6 +1973,7 @@ void Collective::onSquareReplacedEvent(const Level* l, Vec2 pos) {
       info.marked() = getTime() + 10; // wait a little before considering rebuilding
       info.built() = false;
       info.task() = -1;
+      getLevel()->markChanged(pos);
     }
     if (config.getKeepSectors()) {
       sectors->add(pos);
@@ -1926,6 +1985,7 @@ void Collective::onSquareReplacedEvent(const Level* l, Vec2 pos) {
 void Collective::onTrapTriggerEvent(const Level* l, Vec2 pos) {
   if (traps.count(pos) && l == getLevel()) {
     traps.at(pos).armed() = false;
+    getLevel()->markChanged(pos);
     if (traps.at(pos).type() == TrapType::SURPRISE)
       handleSurprise(pos);
   }
@@ -1936,6 +1996,7 @@ void Collective::onTrapDisarmEvent(const Level* l, const Creature* who, Vec2 pos
     control->addMessage(PlayerMessage(who->getName().a() + " disarms a " 
           + Item::getTrapName(traps.at(pos).type()) + " trap.", PlayerMessage::HIGH).setPosition(pos));
     traps.at(pos).armed() = false;
+    getLevel()->markChanged(pos);
   }
 }
 
@@ -1977,9 +2038,10 @@ void Collective::addKnownTile(Vec2 pos) {
         control->onDiscoveredLocation(loc);
       }
     knownTiles.addTile(pos);
+    getLevel()->markChanged(pos);
     if (Task* task = taskMap.getMarked(pos))
       if (task->isImpossible(getLevel()))
-        taskMap.removeTask(task);
+        removeTask(task);
   }
 }
 
@@ -2276,10 +2338,12 @@ void Collective::removeTorch(Vec2 pos) {
   if (auto trigger = torches.at(pos).trigger())
     getLevel()->getSafeSquare(pos)->removeTrigger(trigger);
   torches.erase(pos);
+  getLevel()->markChanged(pos);
 }
 
 void Collective::addTorch(Vec2 pos) {
   torches[pos] = {false, 0.0, -1, (*getAdjacentWall(getLevel(), pos) - pos).getCardinalDir(), nullptr};
+  getLevel()->markChanged(pos);
 }
 
 bool Collective::canPlaceTorch(Vec2 pos) const {
@@ -28,6 +28,7 @@
 #include "collective_teams.h"
 #include "game_info.h"
 #include "collective_config.h"
+#include "flow_field.h"
 
 class Creature;
 class CollectiveControl;
@@ -183,6 +184,8 @@ class Collective : public Task::Callback {
 
   const vector<ItemFetchInfo>& getFetchInfo() const;
   void fetchItems(Vec2 pos, const ItemFetchInfo&, bool ignoreDelayed = false);
+  /** Drops the destination areas made of \paramname{type} after its squares changed.*/
+  void destinationChanged(SquareType type);
 
   struct ConstructionInfo : public NamedTupleBase<CostInfo, bool, double, SquareType, UniqueEntity<Task>::Id> {
     NAMED_TUPLE_STUFF(ConstructionInfo);
@@ -309,6 +312,7 @@ class Collective : public Task::Callback {
   virtual void onBedCreated(Vec2, SquareType fromType, SquareType toType) override;
   virtual void onCopulated(Creature* who, Creature* with) override;
   virtual void onConsumed(Creature* consumer, Creature* who) override;
+  virtual const DestinationArea* getDestinationArea(const vector<SquareType>&) override;
 
 
   private:
@@ -369,6 +373,7 @@ class Collective : public Task::Callback {
   EnumSet<Warning> warnings;
   MoveInfo getDropItems(Creature*);
   MoveInfo getWorkerMove(Creature*);
+  CostInfo removeTask(Task*);
   MoveInfo getTeamMemberMove(Creature*);
   bool usesEquipment(const Creature* c) const;
   void autoEquipment(Creature* creature, bool replace);
@@ -395,6 +400,8 @@ class Collective : public Task::Callback {
   unordered_map<SquareType, set<Vec2>> SERIAL(mySquares);
   map<Vec2, int> SERIAL(squareEfficiency);
   set<Vec2> SERIAL(allSquares);
+  /** Squares that items are brought to, with their types. They are refreshed every turn and not saved.*/
+  vector<pair<vector<SquareType>, DestinationArea>> TRANSIENT(destinationAreas);
   struct AlarmInfo : NamedTupleBase<double, Vec2> {
     NAMED_TUPLE_STUFF(AlarmInfo);
     AlarmInfo() { finishTime() = -1000; }
@@ -16,6 +16,7 @@
 #include "stdafx.h"
 
 #include "creature.h"
+#include "time_queue.h"
 #include "creature_factory.h"
 #include "level.h"
 #include "enemy_check.h"
@@ -196,6 +197,8 @@ vector<const Creature*> Creature::getKills() const {
 
 void Creature::spendTime(double t) {
   time += 100.0 * t / (double) getAttr(AttrType::SPEED);
+  if (timeQueue)
+    timeQueue->updateTime(this);
   hidden = false;
 }
 
@@ -206,7 +209,7 @@ CreatureAction Creature::move(Vec2 direction) {
     return CreatureAction();
   return CreatureAction([=]() {
     stationary = false;
-    Debug() << getName().the() << " moving " << direction;
+    LOG(TRACE, CREATURE) << getName().the() << " moving " << direction;
     if (isAffected(LastingEffect::ENTANGLED)) {
       playerMessage("You can't break free!");
       spendTime(1);
@@ -275,6 +278,8 @@ CreatureAction Creature::swapPosition(Vec2 direction, bool force) {
     playerMessage("Excuse me!");
     level->swapCreatures(this, c);
     c->modViewObject().addMovementInfo({-direction, getTime(), c->getTime()});
+    // Only the creature that moves is updated after its turn, the displaced one now sees from a new square.
+    GlobalEvents.addVisionChangedEvent(c);
   });
 }
 
@@ -296,8 +301,11 @@ void Creature::makeMove() {
   updateVisibleCreatures(Rectangle(getPosition() - Vec2(range, range), getPosition() + Vec2(range, range)));
   if (swapPositionCooldown)
     --swapPositionCooldown;
-  MEASURE(controller->makeMove(), "creature move time");
-  Debug() << getName().bare() << " morale " << getMorale();
+  {
+    PROFILE_ZONE("creature move");
+    controller->makeMove();
+  }
+  LOG(TRACE, CREATURE) << getName().bare() << " morale " << getMorale();
   CHECK(!inEquipChain) << "Someone forgot to finishEquipChain()";
   if (!hidden)
     modViewObject().removeModifier(ViewObject::Modifier::HIDDEN);
@@ -342,7 +350,7 @@ vector<const Square*> Creature::getSquares(const vector<Vec2>& direction) const
 
 CreatureAction Creature::wait() {
   return CreatureAction([=]() {
-    Debug() << getName().the() << " waiting";
+    LOG(TRACE, CREATURE) << getName().the() << " waiting";
     bool keepHiding = hidden;
     spendTime(1);
     hidden = keepHiding;
@@ -391,8 +399,11 @@ void Creature::monsterMessage(const PlayerMessage& playerCanSee, const PlayerMes
 
 void Creature::addSkill(Skill* skill) {
   if (!hasSkill(skill)) {
+    Vision* vision = getVision();
     skills.insert(skill->getId());
     playerMessage(skill->getHelpText());
+    if (getVision() != vision)
+      GlobalEvents.addVisionChangedEvent(this);
   }
 }
 
@@ -408,11 +419,12 @@ const EnumSet<SkillId>& Creature::getDiscreteSkills() const {
   return skills.getAllDiscrete();
 }
 
-vector<Item*> Creature::getPickUpOptions() const {
+const vector<Item*>& Creature::getPickUpOptions() const {
+  static const vector<Item*> none;
   if (!isHumanoid())
-    return vector<Item*>();
+    return none;
   else
-    return getSquare()->getItems();
+    return getSquare()->getAllItems();
 }
 
 string Creature::getPluralName(Item* item, int num) {
@@ -423,16 +435,20 @@ string Creature::getPluralName(Item* item, int num) {
 }
 
 
+bool Creature::canCarry(double weight) const {
+  return getInventoryWeight() + weight <= 2 * getModifier(ModifierType::INV_LIMIT);
+}
+
 CreatureAction Creature::pickUp(const vector<Item*>& items, bool spendT) {
   if (!isHumanoid())
     return CreatureAction("You can't pick up anything!");
-  double weight = getInventoryWeight();
+  double weight = 0;
   for (Item* it : items)
     weight += it->getWeight();
-  if (weight > 2 * getModifier(ModifierType::INV_LIMIT))
+  if (!canCarry(weight))
     return CreatureAction("You are carrying too much to pick this up.");
   return CreatureAction([=]() {
-    Debug() << getName().the() << " pickup ";
+    LOG(TRACE, CREATURE) << getName().the() << " pickup ";
     if (spendT)
       for (auto elem : Item::stackItems(items)) {
         monsterMessage(getName().the() + " picks up " + elem.first);
@@ -453,7 +469,7 @@ CreatureAction Creature::drop(const vector<Item*>& items) {
   if (!isHumanoid())
     return CreatureAction("You can't drop this item!");
   return CreatureAction([=]() {
-    Debug() << getName().the() << " drop";
+    LOG(TRACE, CREATURE) << getName().the() << " drop";
     for (auto elem : Item::stackItems(items)) {
       monsterMessage(getName().the() + " drops " + elem.first);
       playerMessage("You drop " + elem.first);
@@ -511,7 +527,7 @@ CreatureAction Creature::equip(Item* item) {
   if (!equipment.canEquip(item))
     return CreatureAction("This slot is already equiped.");
   return CreatureAction([=]() {
-    Debug() << getName().the() << " equip " << item->getName();
+    LOG(TRACE, CREATURE) << getName().the() << " equip " << item->getName();
     EquipmentSlot slot = item->getEquipmentSlot();
     equipment.equip(item, slot);
     item->onEquip(this);
@@ -531,7 +547,7 @@ CreatureAction Creature::unequip(Item* item) {
   if (numGood(BodyPart::ARM) == 0)
     return CreatureAction("You have no healthy arms!");
   return CreatureAction([=]() {
-    Debug() << getName().the() << " unequip";
+    LOG(TRACE, CREATURE) << getName().the() << " unequip";
     EquipmentSlot slot = item->getEquipmentSlot();
     CHECK(equipment.isEquiped(item)) << "Item not equiped.";
     equipment.unequip(item);
@@ -573,7 +589,7 @@ CreatureAction Creature::bumpInto(Vec2 direction) {
 CreatureAction Creature::applySquare() {
   if (getSquare()->getApplyType(this))
     return CreatureAction([=]() {
-      Debug() << getName().the() << " applying " << getSquare()->getName();;
+      LOG(TRACE, CREATURE) << getName().the() << " applying " << getSquare()->getName();
       getSquare()->onApply(this);
       spendTime(1);
     });
@@ -662,6 +678,7 @@ void Creature::onAffected(LastingEffect effect, bool msg) {
   switch (effect) {
     case LastingEffect::FLYING:
       if (msg) you(MsgType::ARE, "flying!");
+      GlobalEvents.addVisionChangedEvent(this);
       break;
     case LastingEffect::STUNNED:
       if (msg) you(MsgType::ARE, "stunned");
@@ -681,6 +698,7 @@ void Creature::onAffected(LastingEffect effect, bool msg) {
     case LastingEffect::BLIND:
       if (msg) you(MsgType::ARE, "blind!");
       modViewObject().setModifier(ViewObject::Modifier::BLIND);
+      GlobalEvents.addVisionChangedEvent(this);
       break;
     case LastingEffect::INVISIBLE:
       if (!isBlind() && msg)
@@ -740,6 +758,7 @@ void Creature::onTimedOut(LastingEffect effect, bool msg) {
       if (msg) 
         you("can see again");
       modViewObject().removeModifier(ViewObject::Modifier::BLIND);
+      GlobalEvents.addVisionChangedEvent(this);
       break;
     case LastingEffect::INVISIBLE:
       if (msg)
@@ -755,6 +774,7 @@ void Creature::onTimedOut(LastingEffect effect, bool msg) {
     case LastingEffect::FIRE_RESISTANT: if (msg) you(MsgType::ARE, "no longer fire resistant"); break;
     case LastingEffect::FLYING:
       if (msg) you(MsgType::FALL, getSquare()->getName());
+      GlobalEvents.addVisionChangedEvent(this);
       bleed(0.1);
       break;
     case LastingEffect::INSANITY: if (msg) you(MsgType::BECOME, "sane again"); break;
@@ -1027,6 +1047,8 @@ double Creature::getTime() const {
 
 void Creature::setTime(double t) {
   time = t;
+  if (timeQueue)
+    timeQueue->updateTime(this);
 }
 
 void Creature::tick(double realTime) {
@@ -1181,6 +1203,8 @@ void Creature::injureBodyPart(BodyPart part, bool drop) {
     ++lostBodyParts[part];
     if (injuredBodyParts[part] > bodyParts[part])
       --injuredBodyParts[part];
+    if (part == BodyPart::HEAD && bodyParts[part] == 0)
+      GlobalEvents.addVisionChangedEvent(this);
   }
   else if (injuredBodyParts[part] < bodyParts[part])
     ++injuredBodyParts[part];
@@ -1235,7 +1259,7 @@ CreatureAction Creature::attack(const Creature* c1, Optional<AttackLevel> attack
   if (attackLevel1 && !contains(getAttackLevels(), *attackLevel1))
     return CreatureAction("Invalid attack level.");
   return CreatureAction([=] () {
-  Debug() << getName().the() << " attacking " << c->getName().the();
+  LOG(TRACE, CREATURE) << getName().the() << " attacking " << c->getName().the();
   int accuracy =  getModifier(ModifierType::ACCURACY);
   int damage = getModifier(ModifierType::DAMAGE);
   int accuracyVariance = 1 + accuracy / 3;
@@ -1279,7 +1303,7 @@ CreatureAction Creature::attack(const Creature* c1, Optional<AttackLevel> attack
 
 bool Creature::dodgeAttack(const Attack& attack) {
   ++numAttacksThisTurn;
-  Debug() << getName().the() << " dodging " << attack.getAttacker()->getName().bare()
+  LOG(TRACE, CREATURE) << getName().the() << " dodging " << attack.getAttacker()->getName().bare()
     << " accuracy " << attack.getAccuracy() << " dodge " << getModifier(ModifierType::ACCURACY);
   if (const Creature* c = attack.getAttacker()) {
     if (!canSee(c))
@@ -1322,7 +1346,7 @@ bool Creature::takeDamage(const Attack& attack) {
     return false;
   }
   int defense = getModifier(ModifierType::DEFENSE);
-  Debug() << getName().the() << " attacked by " << other->getName().the()
+  LOG(TRACE, CREATURE) << getName().the() << " attacked by " << other->getName().the()
       << " damage " << attack.getStrength() << " defense " << defense;
   if (passiveAttack && other && other->getPosition().dist8(position) == 1) {
     Effect::applyToCreature(other, *passiveAttack, EffectStrength::NORMAL);
@@ -1509,7 +1533,7 @@ CreatureSize Creature::getSize() const {
 }
 
 void Creature::heal(double amount, bool replaceLimbs) {
-  Debug() << getName().the() << " heal";
+  LOG(TRACE, CREATURE) << getName().the() << " heal";
   if (health < 1) {
     health = min(1., health + amount);
     if (health >= 0.5) {
@@ -1548,7 +1572,7 @@ void Creature::bleed(double severity) {
   updateViewObject();
   health -= severity;
   updateViewObject();
-  Debug() << getName().the() << " health " << health;
+  LOG(TRACE, CREATURE) << getName().the() << " health " << health;
 }
 
 void Creature::setOnFire(double amount) {
@@ -1594,7 +1618,7 @@ void Creature::take(vector<PItem> items) {
 
 void Creature::take(PItem item) {
  /* item->identify();
-  Debug() << (specialMonster ? "special monster " : "") + getName().the() << " takes " << item->getNameAndModifiers();*/
+  LOG(TRACE, CREATURE) << (specialMonster ? "special monster " : "") + getName().the() << " takes " << item->getNameAndModifiers();*/
   Item* ref = item.get();
   equipment.addItem(std::move(item));
   if (auto action = equip(ref))
@@ -1612,7 +1636,7 @@ vector<PItem> Creature::getCorpse() {
 
 void Creature::die(const Creature* attacker, bool dropInventory, bool dCorpse) {
   lastAttacker = attacker;
-  Debug() << getName().the() << " dies. Killed by " << (attacker ? attacker->getName().bare() : "");
+  LOG(INFO, CREATURE) << getName().the() << " dies. Killed by " << (attacker ? attacker->getName().bare() : "");
   controller->onKilled(attacker);
   if (attacker)
     attacker->kills.push_back(this);
@@ -1639,7 +1663,7 @@ CreatureAction Creature::flyAway() {
   if (!isAffected(LastingEffect::FLYING) || level->getCoverInfo(position).covered())
     return CreatureAction();
   return CreatureAction([=]() {
-    Debug() << getName().the() << " fly away";
+    LOG(INFO, CREATURE) << getName().the() << " fly away";
     monsterMessage(getName().the() + " flies away.");
     dead = true;
     level->killCreature(this);
@@ -1648,7 +1672,7 @@ CreatureAction Creature::flyAway() {
 
 CreatureAction Creature::disappear() {
   return CreatureAction([=]() {
-    Debug() << getName().the() << " disappears";
+    LOG(INFO, CREATURE) << getName().the() << " disappears";
     monsterMessage(getName().the() + " disappears.");
     dead = true;
     level->killCreature(this);
@@ -1757,7 +1781,7 @@ CreatureAction Creature::copulate(Vec2 direction) {
     if (!other || !canCopulateWith(other))
       return CreatureAction();
     return CreatureAction([=] {
-      Debug() << getName().bare() << " copulate with " << other->getName().bare();
+      LOG(TRACE, CREATURE) << getName().bare() << " copulate with " << other->getName().bare();
       you(MsgType::COPULATE, "with " + other->getName().the());
       spendTime(2);
     });
@@ -1837,7 +1861,7 @@ CreatureAction Creature::consume(Vec2 direction) {
   if (!hasSkill(Skill::get(SkillId::CONSUMPTION)) || !other || !other->isCorporal() || !isFriend(other))
     return CreatureAction();
   return CreatureAction([=] {
-    Debug() << getName().bare() << " consume " << other->getName().bare();
+    LOG(TRACE, CREATURE) << getName().bare() << " consume " << other->getName().bare();
     you(MsgType::CONSUME, other->getName().the());
     consumeBodyParts(other->bodyParts);
     if (*other->humanoid && !*humanoid 
@@ -2045,12 +2069,16 @@ Optional<SpawnType> Creature::getSpawnType() const {
   return spawnType;
 }
 
-bool Creature::canEnter(const MovementType& movement) const {
-  return movement.canEnter(MovementType(getTribe(), {
+MovementType Creature::getMovementType() const {
+  return MovementType(getTribe(), {
       true,
       isAffected(LastingEffect::FLYING),
       hasSkill(Skill::get(SkillId::SWIMMING)),
-      contains({CreatureSize::HUGE, CreatureSize::LARGE}, *size)}));
+      contains({CreatureSize::HUGE, CreatureSize::LARGE}, *size)});
+}
+
+bool Creature::canEnter(const MovementType& movement) const {
+  return movement.canEnter(getMovementType());
  /* return movement.hasTrait(MovementTrait::WALK)
     || (skills[SkillId::SWIMMING] && movement.hasTrait(MovementTrait::SWIM))
     || (contains({CreatureSize::HUGE, CreatureSize::LARGE}, *size) && movement.hasTrait(MovementTrait::WADE))
@@ -2178,10 +2206,11 @@ CreatureAction Creature::moveTowards(Vec2 pos, bool away, bool stepOnTile) {
     if (!sectorOk)
       return CreatureAction();
   }
-  Debug() << "" << getPosition() << (away ? "Moving away from" : " Moving toward ") << pos;
+  LOG(TRACE, PATH) << "" << getPosition() << (away ? "Moving away from" : " Moving toward ") << pos;
   bool newPath = false;
   bool targetChanged = shortestPath && shortestPath->getTarget().dist8(pos) > getPosition().dist8(pos) / 10;
-  if (!shortestPath || targetChanged || shortestPath->isReversed() != away) {
+  if (!shortestPath || targetChanged || shortestPath->isReversed() != away
+      || shortestPath->reachedPartialEnd(getPosition())) {
     newPath = true;
     if (!away)
       shortestPath = ShortestPath(getLevel(), this, pos, getPosition());
@@ -2196,7 +2225,7 @@ CreatureAction Creature::moveTowards(Vec2 pos, bool away, bool stepOnTile) {
   }
   if (newPath)
     return CreatureAction();
-  Debug() << "Reconstructing shortest path.";
+  LOG(TRACE, PATH) << "Reconstructing shortest path.";
   if (!away)
     shortestPath = ShortestPath(getLevel(), this, pos, getPosition());
   else
@@ -2212,11 +2241,27 @@ CreatureAction Creature::moveTowards(Vec2 pos, bool away, bool stepOnTile) {
       return CreatureAction();
     }
   } else {
-    Debug() << "Cannot move toward " << pos;
+    LOG(TRACE, PATH) << "Cannot move toward " << pos;
     return CreatureAction();
   }
 }
 
+CreatureAction Creature::moveTowardsShared(Vec2 pos, const DestinationArea& area) {
+  const int maxDetour = 5;
+  FlowField& field = level->getFlowField(area, getMovementType());
+  // If some other part of the area is much closer than pos, the field would lead away from it.
+  if (field.getDistance(getPosition()) + maxDetour >= getPosition().dist8(pos))
+    // The field doesn't know about creatures, so take the best step that isn't blocked by one.
+    for (Vec2 v : field.getNextMoves(getPosition())) {
+      if (auto action = move(v - getPosition()))
+        return action;
+      if (!level->getSafeSquare(v)->canEnterEmpty(this))
+        if (auto action = destroy(v - getPosition(), Creature::BASH))
+          return action;
+    }
+  return moveTowards(pos);
+}
+
 CreatureAction Creature::moveAway(Vec2 pos, bool pathfinding) {
   if ((pos - getPosition()).length8() <= 5 && pathfinding)
     if (auto action = moveTowards(pos, true, false))
@@ -2354,9 +2399,10 @@ const MinionTaskMap& Creature::getMinionTasks() const {
 
 void Creature::updateVisibleCreatures(Rectangle range) {
   visibleEnemies.clear();
-  for (const Creature* c : getLevel()->getAllCreatures(range)) 
-    if (canSee(c) &&  isEnemy(c))
+  getLevel()->forEachCreature(range, [this] (const Creature* c) {
+      if (canSee(c) && isEnemy(c))
         visibleEnemies.push_back(c);
+  });
   for (const Creature* c : getUnknownAttacker())
     if (!contains(visibleEnemies, c))
       visibleEnemies.push_back(c);
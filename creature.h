@@ -39,7 +39,9 @@
 class Level;
 class Tribe;
 class EnemyCheck;
+class TimeQueue;
 class ViewObject;
+class DestinationArea;
 
 class Creature : private CreatureAttributes, public Renderable, public UniqueEntity<Creature> {
   public:
@@ -145,6 +147,7 @@ class Creature : private CreatureAttributes, public Renderable, public UniqueEnt
   bool dontChase() const;
   Optional<SpawnType> getSpawnType() const;
   bool canEnter(const MovementType&) const;
+  MovementType getMovementType() const;
 
   int numBodyParts(BodyPart) const;
   int numLost(BodyPart) const;
@@ -179,8 +182,9 @@ class Creature : private CreatureAttributes, public Renderable, public UniqueEnt
   CreatureAction move(Vec2 direction);
   CreatureAction swapPosition(Vec2 direction, bool force = false);
   CreatureAction wait();
-  vector<Item*> getPickUpOptions() const;
+  const vector<Item*>& getPickUpOptions() const;
   CreatureAction pickUp(const vector<Item*>& item, bool spendTime = true);
+  bool canCarry(double additionalWeight) const;
   CreatureAction drop(const vector<Item*>& item);
   void drop(vector<PItem> item);
   CreatureAction attack(const Creature*, Optional<AttackLevel> = Nothing(), bool spendTime = true);
@@ -222,6 +226,9 @@ class Creature : private CreatureAttributes, public Renderable, public UniqueEnt
   Item* getWeapon() const;
 
   CreatureAction moveTowards(Vec2 pos, bool stepOnTile = false);
+  /** Moves towards \paramname{pos}, which lies in an area that many creatures head to, eg. a storage. The way
+      to the area is shared between them, only the last steps are planned separately.*/
+  CreatureAction moveTowardsShared(Vec2 pos, const DestinationArea&);
   CreatureAction moveAway(Vec2 pos, bool pathfinding = true);
   CreatureAction continueMoving();
   CreatureAction stayIn(const Location*);
@@ -305,6 +312,8 @@ class Creature : private CreatureAttributes, public Renderable, public UniqueEnt
   Level* SERIAL2(level, nullptr);
   Vec2 SERIAL(position);
   double SERIAL2(time, 1);
+  friend class TimeQueue;
+  TimeQueue* timeQueue = nullptr;
   Equipment SERIAL(equipment);
   Optional<ShortestPath> SERIAL(shortestPath);
   unordered_set<const Creature*> SERIAL(knownHiding);
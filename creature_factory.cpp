@@ -911,7 +911,7 @@ PCreature getSpecial(const string& name, Tribe* tribe, bool humanoid, Controller
     }
 
   }
-  Debug() << c->getDescription();
+  LOG(INFO, CREATURE) << c->getDescription();
   return c;
 }
 
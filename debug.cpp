@@ -20,35 +20,361 @@
 
 
 
-Debug::Debug(DebugType t, const string& msg, int line) 
-    : out((string[]) { "INFO ", "FATAL "}[t] + msg + ":" + toString(line) + " "), type(t) {
+namespace {
+
+struct LogRecord {
+  long long time;
+  LogLevel level;
+  LogCategory category;
+  const char* file;
+  int line;
+  string message;
+};
+
+/** Ring of records with a single producer, the owning thread, and a single consumer, the writer thread.*/
+struct LogBuffer {
+  static const int size = 1 << 12;
+  LogBuffer() : records(size) {}
+  vector<LogRecord> records;
+  atomic<long long> numPushed {0};
+  atomic<long long> numPopped {0};
+  atomic<bool> owned {true};
+};
+
+std::mutex buffersMutex;
+vector<unique_ptr<LogBuffer>> buffers;
+
+/** Gives the buffer back when its thread finishes, so that short lived threads don't leak buffers.*/
+struct BufferHandle {
+  LogBuffer* buffer = nullptr;
+
+  ~BufferHandle() {
+    if (buffer)
+      buffer->owned = false;
+  }
+};
+
+LogBuffer& getThreadBuffer() {
+  static thread_local BufferHandle handle;
+  if (!handle.buffer) {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (auto& buffer : buffers)
+      if (!buffer->owned && buffer->numPopped == buffer->numPushed) {
+        buffer->owned = true;
+        handle.buffer = buffer.get();
+        return *handle.buffer;
+      }
+    buffers.emplace_back(new LogBuffer());
+    handle.buffer = buffers.back().get();
+  }
+  return *handle.buffer;
+}
+
+long long now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char logHeader[] = "KEEPERRL_LOG_1\n";
+
+enum { FILE_NAME = 0, RECORD = 1 };
+
+void writeInt(std::ostream& out, unsigned long long value, int numBytes) {
+  for (int i = 0; i < numBytes; ++i)
+    out.put(char((value >> (8 * i)) & 255));
+}
+
+bool readInt(std::istream& in, unsigned long long& value, int numBytes) {
+  value = 0;
+  for (int i = 0; i < numBytes; ++i) {
+    int c = in.get();
+    if (c == EOF)
+      return false;
+    value |= (unsigned long long) c << (8 * i);
+  }
+  return true;
+}
+
+bool readString(std::istream& in, string& s, int numBytes) {
+  s.resize(numBytes);
+  return numBytes == 0 || in.read(&s[0], numBytes);
+}
+
+/** Drains the thread buffers to the file. Records are written as they were queued by each thread,
+    the file names are written once and then referred to by index.*/
+class LogWriter {
+  public:
+  /** Starts writing to the file. If the writer is already running, it first writes out everything queued
+      so far to the current file.*/
+  void start(const string& path, bool append) {
+    stopThread();
+    ifstream in(path, std::ios::binary);
+    string header;
+    bool isLog = append && readString(in, header, sizeof(logHeader) - 1) && header == logHeader;
+    in.close();
+    output.open(path, std::ios::binary | (isLog ? std::ios::app : std::ios::trunc));
+    if (!isLog)
+      output.write(logHeader, sizeof(logHeader) - 1);
+    currentPath = path;
+    fileIds.clear();
+    if (!startTime)
+      startTime = now();
+    running = true;
+    writerThread = thread([this] { run(); });
+  }
+
+  bool isRunning() const {
+    return running;
+  }
+
+  const string& getPath() const {
+    return currentPath;
+  }
+
+  long long getTime() const {
+    return now() - startTime;
+  }
+
+  void flush() {
+    if (!running)
+      return;
+    std::unique_lock<std::mutex> lock(mutex);
+    long long request = ++numFlushRequests;
+    wakeUp.notify_all();
+    flushed.wait(lock, [&] { return numFlushed >= request; });
+  }
+
+  ~LogWriter() {
+    stopThread();
+  }
+
+  private:
+  void stopThread() {
+    if (writerThread.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+        wakeUp.notify_all();
+      }
+      writerThread.join();
+      stop = false;
+      output.close();
+    }
+  }
+
+  void run() {
+    while (1) {
+      long long request;
+      bool stopping;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        request = numFlushRequests;
+        stopping = stop;
+      }
+      bool wrote = drain();
+      if (wrote || request > numFlushed)
+        output.flush();
+      std::unique_lock<std::mutex> lock(mutex);
+      numFlushed = request;
+      flushed.notify_all();
+      if (stopping)
+        break;
+      if (!wrote && !stop && numFlushRequests == request)
+        wakeUp.wait_for(lock, std::chrono::milliseconds(10));
+    }
+  }
+
+  bool drain() {
+    vector<LogBuffer*> toDrain;
+    {
+      std::lock_guard<std::mutex> lock(buffersMutex);
+      for (auto& buffer : buffers)
+        toDrain.push_back(buffer.get());
+    }
+    bool wrote = false;
+    for (LogBuffer* buffer : toDrain) {
+      long long end = buffer->numPushed.load(std::memory_order_acquire);
+      for (long long i = buffer->numPopped; i < end; ++i) {
+        writeRecord(buffer->records[i % LogBuffer::size]);
+        buffer->numPopped.store(i + 1, std::memory_order_release);
+        wrote = true;
+      }
+    }
+    return wrote;
+  }
+
+  void writeRecord(const LogRecord& record) {
+    if (!fileIds.count(record.file)) {
+      int id = fileIds.size();
+      fileIds[record.file] = id;
+      int length = strlen(record.file);
+      writeInt(output, FILE_NAME, 1);
+      writeInt(output, id, 2);
+      writeInt(output, length, 2);
+      output.write(record.file, length);
+    }
+    writeInt(output, RECORD, 1);
+    writeInt(output, record.time, 8);
+    writeInt(output, int(record.level), 1);
+    writeInt(output, int(record.category), 1);
+    writeInt(output, fileIds.at(record.file), 2);
+    writeInt(output, record.line, 4);
+    writeInt(output, record.message.size(), 4);
+    output.write(record.message.data(), record.message.size());
+  }
+
+  ofstream output;
+  string currentPath;
+  long long startTime = 0;
+  atomic<bool> running {false};
+  thread writerThread;
+  std::mutex mutex;
+  std::condition_variable wakeUp;
+  std::condition_variable flushed;
+  long long numFlushRequests = 0;
+  long long numFlushed = 0;
+  bool stop = false;
+  unordered_map<const char*, int> fileIds;
+};
+
+LogWriter writer;
+
+const char* levelNames[] = { "TRACE", "INFO", "WARNING", "FATAL" };
+const char* categoryNames[] = { "GENERAL", "MODEL", "CREATURE", "COLLECTIVE", "ITEM", "LEVEL", "PATH",
+    "LEVEL_GEN", "GUI" };
+
+}
+
+atomic<int> Log::minLevel(int(LogLevel::INFO));
+atomic<unsigned> Log::categories((1 << numLogCategories) - 1);
+
+void Log::init(const string& path, bool append) {
+  writer.start(path, append);
+}
+
+const string& Log::getPath() {
+  return writer.getPath();
+}
+
+const char* Log::getName(LogLevel level) {
+  return levelNames[int(level)];
+}
+
+const char* Log::getName(LogCategory category) {
+  return categoryNames[int(category)];
+}
+
+bool Log::setLevel(const string& name) {
+  for (int i = 0; i <= int(LogLevel::FATAL); ++i)
+    if (toUpper(name) == levelNames[i]) {
+      minLevel = i;
+      return true;
+    }
+  return false;
+}
+
+LogLevel Log::getLevel() {
+  return LogLevel(minLevel.load());
+}
+
+bool Log::setCategories(const string& names) {
+  unsigned mask = 0;
+  for (string name : split(names, {','})) {
+    int i = 0;
+    while (i < numLogCategories && toUpper(name) != categoryNames[i])
+      ++i;
+    if (i == numLogCategories)
+      return false;
+    mask |= 1 << i;
+  }
+  categories = mask;
+  return true;
+}
+
+void Log::write(LogLevel level, LogCategory category, const char* file, int line, const string& msg) {
+  if (!writer.isRunning())
+    return;
+  LogBuffer& buffer = getThreadBuffer();
+  long long index = buffer.numPushed.load(std::memory_order_relaxed);
+  // If the writer falls behind, wait for it rather than lose records.
+  while (index - buffer.numPopped.load(std::memory_order_acquire) >= LogBuffer::size)
+    std::this_thread::yield();
+  LogRecord& record = buffer.records[index % LogBuffer::size];
+  record.time = writer.getTime();
+  record.level = level;
+  record.category = category;
+  record.file = file;
+  record.line = line;
+  record.message.assign(msg);
+  buffer.numPushed.store(index + 1, std::memory_order_release);
+}
+
+void Log::flush() {
+  writer.flush();
+}
+
+void Log::print(const string& path, std::ostream& out) {
+  ifstream in(path, std::ios::binary);
+  string header;
+  if (!readString(in, header, sizeof(logHeader) - 1) || header != logHeader) {
+    out << path << " is not a log file\n";
+    return;
+  }
+  vector<string> fileNames;
+  unsigned long long kind, id, length, time, level, category, line;
+  string text;
+  // A record that is still being written by the game is silently skipped.
+  while (readInt(in, kind, 1)) {
+    if (kind == FILE_NAME) {
+      if (!readInt(in, id, 2) || !readInt(in, length, 2) || !readString(in, text, length))
+        break;
+      fileNames.resize(max<int>(fileNames.size(), id + 1));
+      fileNames[id] = text;
+    } else if (kind == RECORD) {
+      if (!readInt(in, time, 8) || !readInt(in, level, 1) || !readInt(in, category, 1) || !readInt(in, id, 2)
+          || !readInt(in, line, 4) || !readInt(in, length, 4) || !readString(in, text, length))
+        break;
+      if (level > int(LogLevel::FATAL) || category >= numLogCategories || id >= fileNames.size())
+        break;
+      char timeText[20];
+      snprintf(timeText, sizeof(timeText), "%.6f", double(time) / 1e9);
+      out << timeText << " " << levelNames[level] << " " << categoryNames[category] << " "
+          << fileNames[id] << ":" << line << " " << text << "\n";
+    } else
+      break;
+  }
+}
+
+Debug::Debug(DebugType t, const string& msg, int l) 
+    : out((string[]) { "INFO ", "FATAL "}[t] + msg + ":" + toString(l) + " "), type(t),
+      level(t == FATAL ? LogLevel::FATAL : LogLevel::INFO), category(LogCategory::GENERAL) {
 #ifdef RELEASE
   if (t == DebugType::FATAL)
     throw out;
 #endif
 }
 
-static ofstream output;
+Debug::Debug(LogLevel l, LogCategory c, const char* f, int ln)
+    : type(l == LogLevel::FATAL ? FATAL : INFO), level(l), category(c), file(f), line(ln) {
+}
 
 void Debug::init() {
-  output.open("log.out");
+  Log::init("log.out");
 }
 
 void Debug::add(const string& a) {
   out += a;
 }
+
 Debug::~Debug() {
+  if (type == FATAL || Log::isEnabled(level, category))
+    Log::write(level, category, file, line, out);
   if (type == FATAL) {
-    output << out << endl;
-    output.flush();
+    Log::flush();
     throw out;
-  } else {
-#ifndef RELEASE
-    output << out << endl;
-    output.flush();
-#endif
   }
 }
+
 Debug& Debug::operator <<(const string& msg) {
   add(msg);
   return *this;
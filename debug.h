@@ -36,22 +36,76 @@
 #ifndef WINDOWS
 
 #define MEASURE(exp, text) do { \
+  PROFILE_ZONE(text); \
   timeval time1; \
   gettimeofday(&time1, nullptr); \
   suseconds_t m1 = time1.tv_usec + time1.tv_sec * 1000000; \
   exp; \
   gettimeofday(&time1, nullptr); \
   suseconds_t m2 = time1.tv_usec + time1.tv_sec * 1000000; \
-  Debug() << text << " " << int(m2 - m1);} while(0);
+  LOG(TRACE, GENERAL) << text << " " << int(m2 - m1);} while(0)
 
 #else
 
-#define MEASURE(exp, text) exp;
+#define MEASURE(exp, text) do { PROFILE_ZONE(text); exp; } while(0)
 
 #endif
 
 enum DebugType { INFO, FATAL };
 
+enum class LogLevel { TRACE, INFO, WARNING, FATAL };
+
+enum class LogCategory { GENERAL, MODEL, CREATURE, COLLECTIVE, ITEM, LEVEL, PATH, LEVEL_GEN, GUI };
+
+const int numLogCategories = int(LogCategory::GUI) + 1;
+
+/** Levels below this are compiled out. Can be overridden with -DLOG_MIN_LEVEL=...*/
+#ifndef LOG_MIN_LEVEL
+#ifdef RELEASE
+#define LOG_MIN_LEVEL WARNING
+#else
+#define LOG_MIN_LEVEL TRACE
+#endif
+#endif
+
+/** Asynchronous log. Records are queued in per thread ring buffers and a background thread writes them
+    to the file in a compact binary format, which can be read with print().*/
+class Log {
+  public:
+  /** Starts the writer thread. Until then nothing is logged. Called again, it moves the log to another file.
+      With \paramname{append}, records are added to the end of an existing log file.*/
+  static void init(const string& path, bool append = false);
+
+  static const string& getPath();
+
+  static bool isEnabled(LogLevel level, LogCategory category) {
+    return int(level) >= minLevel.load(std::memory_order_relaxed)
+        && (categories.load(std::memory_order_relaxed) & (1 << int(category)));
+  }
+
+  /** Returns false if the name is not a known level.*/
+  static bool setLevel(const string&);
+  static LogLevel getLevel();
+
+  /** Logs only the given comma separated categories. Returns false if any of the names is unknown.*/
+  static bool setCategories(const string&);
+
+  static void write(LogLevel, LogCategory, const char* file, int line, const string& msg);
+
+  /** Blocks until everything logged so far is in the file.*/
+  static void flush();
+
+  /** Pretty prints a log file written by the writer thread.*/
+  static void print(const string& path, std::ostream&);
+
+  static const char* getName(LogLevel);
+  static const char* getName(LogCategory);
+
+  private:
+  static atomic<int> minLevel;
+  static atomic<unsigned> categories;
+};
+
 class NoDebug {
   public:
   NoDebug& operator <<(const string& msg) { return *this;}
@@ -65,9 +119,12 @@ class NoDebug {
   NoDebug& operator<<(const vector<vector<T> >& container) {return *this;}
 };
 
+/** Builds a log record, use LOG() for messages and FAIL or CHECK() for fatal errors. Messages that aren't
+    FATAL are filtered like LOG() before they are written.*/
 class Debug {
   public:
-  Debug(DebugType t = INFO, const string& msg = "", int line = 0);
+  Debug(DebugType t, const string& msg = "", int line = 0);
+  Debug(LogLevel, LogCategory, const char* file, int line);
   static void init();
   Debug& operator <<(const string& msg);
   Debug& operator <<(const int msg);
@@ -83,9 +140,23 @@ class Debug {
   private:
   string out;
   DebugType type;
+  LogLevel level;
+  LogCategory category;
+  const char* file = "";
+  int line = 0;
   void add(const string& a);
 };
 
+struct LogVoidify {
+  void operator &(const Debug&) {}
+};
+
+/** Logs a message, eg. LOG(INFO, PATH) << "Path from " << from. If the level or category is disabled, the
+    streamed arguments are not evaluated.*/
+#define LOG(level, category) \
+  (LogLevel::level < LogLevel::LOG_MIN_LEVEL || !Log::isEnabled(LogLevel::level, LogCategory::category)) \
+      ? (void) 0 : LogVoidify() & Debug(LogLevel::level, LogCategory::category, __FILE__, __LINE__)
+
 template <class T, class V>
 const T& valueCheck(const T& e, const V& v, const string& msg) {
   if (e != v) Debug(FATAL) << msg << " (" << e << " != " << v << ")";
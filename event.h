@@ -56,6 +56,9 @@ class EventListener {
   EVENT(TrapTriggerEvent, const Level*, Vec2 pos);
   EVENT(TrapDisarmEvent, const Level*, const Creature*, Vec2 pos);
   EVENT(SquareReplacedEvent, const Level*, Vec2 pos);
+  // triggered when the terrain or light in the area changes, anything within sight range of it may see differently
+  EVENT(VisibilityChangedEvent, const Level*, Rectangle area);
+  EVENT(VisionChangedEvent, const Creature*);
   EVENT(ChangeLevelEvent, const Creature*, const Level* from, Vec2 pos, const Level* to, Vec2 toPos);
   EVENT(AlarmEvent, const Level*, Vec2 pos);
   EVENT(TechBookEvent, Technology*);
@@ -18,137 +18,293 @@
 #include "field_of_view.h"
 #include "square.h"
 
-template <class Archive> 
-void FieldOfView::serialize(Archive& ar, const unsigned int version) {
-  ar & SVAR(squares)
-     & SVAR(visibility)
-     & SVAR(vision);
-  CHECK_SERIAL;
+FieldOfView::FieldOfView(const Table<PSquare>& s, Vision* v, size_t budget)
+  : squares(&s), vision(v), width(s.getWidth()), height(s.getHeight()), opaque((width * height + 63) / 64),
+    opaqueColumns(opaque.size()), memoryBudget(budget) {
+  for (Vec2 pos : s.getBounds())
+    setOpaque(pos, !s[pos]->canSeeThru(vision));
 }
 
-SERIALIZABLE(FieldOfView);
+FieldOfView::FieldOfView(const Table<bool>& o, size_t budget)
+  : width(o.getWidth()), height(o.getHeight()), opaque((width * height + 63) / 64),
+    opaqueColumns(opaque.size()), memoryBudget(budget) {
+  for (Vec2 pos : o.getBounds())
+    setOpaque(pos, o[pos]);
+}
+
+/** Reads length <= 64 bits of a line of a bitmap made of numLines lines of lineLength bits each, starting from
+    the given position in the line. Bits outside of the bitmap are set.*/
+static uint64_t getLineBits(const vector<uint64_t>& bits, int lineLength, int numLines, int line, int pos,
+    int length) {
+  uint64_t all = ~uint64_t(0) >> (64 - length);
+  if (line < 0 || line >= numLines)
+    return all;
+  int from = max(0, pos);
+  int to = min(lineLength, pos + length);
+  if (from >= to)
+    return all;
+  int index = line * lineLength + from;
+  int offset = index % 64;
+  uint64_t ret = bits[index / 64] >> offset;
+  if (offset > 0 && offset + to - from > 64)
+    ret |= bits[index / 64 + 1] << (64 - offset);
+  uint64_t inside = (~uint64_t(0) >> (64 - (to - from))) << (from - pos);
+  return ((ret << (from - pos)) & inside) | (all & ~inside);
+}
+
+uint64_t FieldOfView::getOpaqueRow(int x, int y, int length) const {
+  return getLineBits(opaque, width, height, y, x, length);
+}
+
+uint64_t FieldOfView::getOpaqueColumn(int x, int y, int length) const {
+  return getLineBits(opaqueColumns, height, width, x, y, length);
+}
+
+static void setBit(vector<uint64_t>& bits, int index, bool state) {
+  if (state)
+    bits[index / 64] |= uint64_t(1) << (index % 64);
+  else
+    bits[index / 64] &= ~(uint64_t(1) << (index % 64));
+}
 
-template <class Archive> 
-void FieldOfView::Visibility::serialize(Archive& ar, const unsigned int version) {
-  ar& SVAR(visible)
-    & SVAR(visibleTiles)
-    & SVAR(px)
-    & SVAR(py);
-  CHECK_SERIAL;
+void FieldOfView::setOpaque(Vec2 pos, bool state) {
+  setBit(opaque, pos.y * width + pos.x, state);
+  setBit(opaqueColumns, pos.x * height + pos.y, state);
 }
 
-SERIALIZABLE(FieldOfView::Visibility);
-SERIALIZATION_CONSTRUCTOR_IMPL(FieldOfView);
-SERIALIZATION_CONSTRUCTOR_IMPL2(FieldOfView, Visibility);
+FieldOfView::Visibility& FieldOfView::useVisibility(Vec2 pos) {
+  auto elem = cached.find(pos);
+  if (elem != cached.end()) {
+    ++stats.hits;
+    visibility.splice(visibility.begin(), visibility, elem->second);
+    return visibility.front();
+  }
+  ++stats.misses;
+  PROFILE_ZONE("field of view");
+  visibility.emplace_front(*this, pos.x, pos.y);
+  cached[pos] = visibility.begin();
+  memoryUsed += visibility.front().getMemoryUsage();
+  while (memoryUsed > memoryBudget && visibility.size() > 1) {
+    ++stats.evictions;
+    erase(--visibility.end());
+  }
+  return visibility.front();
+}
 
-FieldOfView::FieldOfView(const Table<PSquare>& s, Vision* v) 
-  : squares(&s), visibility(s.getWidth(), s.getHeight()), vision(v) {
+void FieldOfView::erase(std::list<Visibility>::iterator elem) {
+  memoryUsed -= elem->getMemoryUsage();
+  cached.erase(elem->getPosition());
+  visibility.erase(elem);
+}
+
+const FieldOfView::CacheStats& FieldOfView::getCacheStats() const {
+  return stats;
 }
 
 bool FieldOfView::canSee(Vec2 from, Vec2 to) {
   if ((from - to).lengthD() > sightRange)
     return false;
-  if (!visibility[from])
-    visibility[from] = Visibility(*squares, vision, from.x, from.y);
-  return visibility[from]->checkVisible(to.x - from.x, to.y - from.y);
+  return useVisibility(from).checkVisible(to.x - from.x, to.y - from.y);
 }
   
 void FieldOfView::squareChanged(Vec2 pos) {
-  vector<Vec2> updateList;
-  if (!visibility[pos])
-    visibility[pos] = Visibility(*squares, vision, pos.x, pos.y);
-  vector<Vec2> visible = visibility[pos]->getVisibleTiles();
-  for (Vec2 v : visible)
-    if (visibility[v] && visibility[v]->checkVisible(pos.x - v.x, pos.y - v.y)) {
-      visibility[v] = Nothing();
+  CHECK(squares) << "Field of view isn't attached to a level";
+  setOpaque(pos, !(*squares)[pos]->canSeeThru(vision));
+  vector<Vec2> visible;
+  if (cached.count(pos))
+    visible = cached.at(pos)->getVisibleTiles();
+  else
+    visible = Visibility(*this, pos.x, pos.y).getVisibleTiles();
+  for (Vec2 v : visible) {
+    auto elem = cached.find(v);
+    if (elem != cached.end() && elem->second->checkVisible(pos.x - v.x, pos.y - v.y))
+      erase(elem->second);
+  }
+}
+
+namespace {
+
+const int sightRange = FieldOfView::sightRange;
+
+/** Bits from..to, inclusive.*/
+uint64_t bitRange(int from, int to) {
+  return (~uint64_t(0) >> (63 - to)) & (~uint64_t(0) << from);
+}
+
+int highestBit(uint64_t v) {
+  return 63 - __builtin_clzll(v);
+}
+
+/** Reverses the order of the lowest 2 * sightRange + 1 bits.*/
+uint64_t reverseLine(uint64_t v) {
+  v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+  v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+  v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+  v = ((v >> 8) & 0x00FF00FF00FF00FFULL) | ((v & 0x00FF00FF00FF00FFULL) << 8);
+  v = ((v >> 16) & 0x0000FFFF0000FFFFULL) | ((v & 0x0000FFFF0000FFFFULL) << 16);
+  v = (v >> 32) | (v << 32);
+  return v >> (63 - 2 * sightRange);
+}
+
+/** Transposes a 64x64 bit matrix, bit j of m[i] is swapped with bit i of m[j].*/
+void transpose(uint64_t (&m)[64]) {
+  uint64_t mask = 0x00000000FFFFFFFFULL;
+  for (int j = 32; j > 0; j >>= 1, mask ^= mask << j)
+    for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+      uint64_t t = ((m[k] >> j) ^ m[k | j]) & mask;
+      m[k] ^= t << j;
+      m[k | j] ^= t;
     }
 }
 
-void FieldOfView::Visibility::setVisible(int x, int y) {
-  if (!visible[x + sightRange][y + sightRange] && x * x + y * y <= sightRange * sightRange) {
-    visible[x + sightRange][y + sightRange] = 1;
-    visibleTiles.push_back(Vec2(px + x, py + y));
-  }
+/** The part of a line between two slopes, as in the original recursive shadowcasting.*/
+struct Interval {
+  int x1, y1, x2, y2;
+};
+
+void addInterval(vector<Interval>& intervals, const Interval& interval) {
+  if (interval.y2 * interval.x1 < interval.y1 * interval.x2)
+    intervals.push_back(interval);
 }
 
-static int totalIter = 0;
-static int numSamples = 0;
-
-FieldOfView::Visibility::Visibility(const Table<PSquare>& squares, Vision* vision, int x, int y) : px(x), py(y) {
-  memset(visible, 0, (2 * sightRange + 1) * (2 * sightRange + 1));
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange, 2,-1,1,1,1,
-      [&](int px, int py) { return !squares[x + px][y + py]->canSeeThru(vision); },
-      [&](int px, int py) { setVisible(px ,py); });
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange, 2,-1,1,1,1,
-      [&](int px, int py) { return !squares[x + py][y - px]->canSeeThru(vision); },
-      [&](int px, int py) { setVisible(py, -px); });
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange,2,-1,1,1,1,
-      [&](int px, int py) { return !squares[x - px][y - py]->canSeeThru(vision); },
-      [&](int px, int py) { setVisible(-px, -py); });
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange,2,-1,1,1,1,
-      [&](int px, int py) { return !squares[x - py][y + px]->canSeeThru(vision); },
-      [&](int px, int py) { setVisible(-py, px); });
-  setVisible(0, 0);
-/*  ++numSamples;
-  totalIter += visibleTiles.size();
-  if (numSamples%100 == 0)
-    Debug() << numSamples << " iterations " << totalIter / numSamples << " avg";*/
-}
-
-const vector<Vec2>& FieldOfView::Visibility::getVisibleTiles() const {
-  return visibleTiles;
-}
-
-const vector<Vec2>& FieldOfView::getVisibleTiles(Vec2 from) {
-  if (!visibility[from]) {
-    visibility[from] = Visibility(*squares, vision, from.x, from.y);
-  }
-  return visibility[from]->getVisibleTiles();
-}
-
-
-void FieldOfView::Visibility::calculate(int left, int right, int up, int h, int x1, int y1, int x2, int y2,
-    function<bool (int, int)> isBlocking, function<void (int, int)> setVisible){
-  if (y2*x1>=y1*x2) return;
-  if (h>up) return;
-  int leftx=x1, lefty=y1, rightx=x2, righty=y2;
-  int left_v=(int)floor((double)x1/y1*(h)), 
-      right_v=(int)ceil((double)x2/y2*(h)),
-      left_b=(int)floor((double)x1/y1*(h-1)),
-      right_b=(int)ceil((double)x2/y2*(h+1));
-  if (left_v % 2)
-    ++left_v;
-  if (right_v % 2)
-    --right_v;
-  if(left_b % 2)
-    ++left_b;
-  if(right_b % 2)
-    --right_b;
-
-  if(left_b>=-left && left_b<=right && isBlocking(left_b/2,h/2)){
-    leftx=left_b+1;
-    lefty=h+(left_b>=0?-1:1);
-  }
-  if(left_v<-left) left_v=-left;
-  if(right_v>right) right_v=right;
-  bool prevBlocking = false;
-  for (int i=left_v/2;i<=right_v/2;++i){
-    setVisible(i, h / 2);
-    bool blocking = isBlocking(i, h / 2);
-    if(i > left_v / 2 && blocking && !prevBlocking)
-      calculate(left, right, up, h + 2, leftx, lefty, i * 2 - 1, h + (i<=0 ? -1:1), isBlocking, setVisible);
-    if(blocking){
-      leftx=i*2+1;
-      lefty=h+(i>=0?-1:1);
+/** Casts shadows in one quadrant, a line at a time, and returns the number of lines reached. Bit
+    sightRange + i of getLine(r) is set if the cell i of line r blocks sight, and the same bit of lit[r]
+    is set if it's visible. Line 0 is the origin. Each interval is split at the blocking cells into the
+    intervals of the next line, the same way the recursive version did it, so the visible cells are the same.*/
+template <class GetLine>
+int castShadows(const GetLine& getLine, uint64_t* lit) {
+  const int range = 2 * sightRange;
+  static thread_local vector<Interval> current, next;
+  current.assign(1, {-1, 1, 1, 1});
+  int h = 2;
+  for (; h <= range && !current.empty(); h += 2) {
+    uint64_t line = getLine(h / 2);
+    lit[h / 2] = 0;
+    next.clear();
+    for (const Interval& interval : current) {
+      int leftX = interval.x1;
+      int leftY = interval.y1;
+      int leftV = (int) floor((double) interval.x1 / interval.y1 * h);
+      int rightV = (int) ceil((double) interval.x2 / interval.y2 * h);
+      int leftB = (int) floor((double) interval.x1 / interval.y1 * (h - 1));
+      if (leftV % 2)
+        ++leftV;
+      if (rightV % 2)
+        --rightV;
+      if (leftB % 2)
+        ++leftB;
+      if (leftB >= -range && leftB <= range && ((line >> (leftB / 2 + sightRange)) & 1)) {
+        leftX = leftB + 1;
+        leftY = h + (leftB >= 0 ? -1 : 1);
+      }
+      int from = max(leftV, -range) / 2 + sightRange;
+      int to = min(rightV, range) / 2 + sightRange;
+      if (from <= to) {
+        uint64_t cells = bitRange(from, to);
+        lit[h / 2] |= cells;
+        uint64_t blocking = line & cells;
+        // Every run of blocking cells, except one at the start, closes an interval of the next line.
+        uint64_t runStarts = blocking & ~(blocking << 1) & ~(uint64_t(1) << from);
+        for (; runStarts; runStarts &= runStarts - 1) {
+          int start = __builtin_ctzll(runStarts);
+          if (uint64_t before = blocking & ((uint64_t(1) << start) - 1)) {
+            int i = highestBit(before) - sightRange;
+            leftX = i * 2 + 1;
+            leftY = h + (i >= 0 ? -1 : 1);
+          }
+          int i = start - sightRange;
+          addInterval(next, {leftX, leftY, i * 2 - 1, h + (i <= 0 ? -1 : 1)});
+        }
+        if (blocking) {
+          int i = highestBit(blocking) - sightRange;
+          leftX = i * 2 + 1;
+          leftY = h + (i >= 0 ? -1 : 1);
+        }
+      }
+      addInterval(next, {leftX, leftY, interval.x2, interval.y2});
     }
-    prevBlocking = blocking;
+    std::swap(current, next);
   }
-  calculate(left, right, up, h + 2, leftx, lefty, rightx, righty, isBlocking, setVisible);
+  return h / 2 - 1;
+}
+
+/** Bit sightRange + x of the row sightRange + y is set if (x, y) is within sight range.*/
+const uint64_t* getSightCircle() {
+  struct Circle {
+    Circle() {
+      for (int y : Range(-sightRange, sightRange + 1))
+        for (int x : Range(-sightRange, sightRange + 1))
+          if (x * x + y * y <= sightRange * sightRange)
+            rows[y + sightRange] |= uint64_t(1) << (x + sightRange);
+    }
+    uint64_t rows[2 * sightRange + 1] = {0};
+  };
+  static Circle circle;
+  return circle.rows;
+}
+
 }
 
+FieldOfView::Visibility::Visibility(const FieldOfView& fov, int x, int y) : px(x), py(y) {
+  // Quadrants 0 and 2 go along rows and the other two along columns, so all four read the opacity of a
+  // whole line at once, reversed when they run backwards. The lines are only read until the shadows
+  // close the quadrant. The rows are stored directly and the columns are scattered into them bit by bit,
+  // which is cheaper than a transposition when little is visible.
+  const int left = x - sightRange;
+  const int top = y - sightRange;
+  uint64_t lit[sightRange + 1];
+  std::fill(visible, visible + diameter, 0);
+  int numLines = castShadows([&](int r) { return fov.getOpaqueRow(left, y + r, diameter); }, lit);
+  for (int r = 1; r <= numLines; ++r)
+    visible[sightRange + r] |= lit[r];
+  numLines = castShadows([&](int r) { return reverseLine(fov.getOpaqueColumn(x + r, top, diameter)); }, lit);
+  for (int r = 1; r <= numLines; ++r)
+    for (uint64_t cells = lit[r]; cells; cells &= cells - 1)
+      visible[2 * sightRange - __builtin_ctzll(cells)] |= uint64_t(1) << (sightRange + r);
+  numLines = castShadows([&](int r) { return reverseLine(fov.getOpaqueRow(left, y - r, diameter)); }, lit);
+  for (int r = 1; r <= numLines; ++r)
+    visible[sightRange - r] |= reverseLine(lit[r]);
+  numLines = castShadows([&](int r) { return fov.getOpaqueColumn(x - r, top, diameter); }, lit);
+  for (int r = 1; r <= numLines; ++r)
+    for (uint64_t cells = lit[r]; cells; cells &= cells - 1)
+      visible[__builtin_ctzll(cells)] |= uint64_t(1) << (sightRange - r);
+  const uint64_t* circle = getSightCircle();
+  for (int i = 0; i < diameter; ++i)
+    visible[i] = visible[i] & circle[i];
+  visible[sightRange] |= uint64_t(1) << sightRange;
+}
+
+vector<Vec2> FieldOfView::Visibility::getVisibleTiles() const {
+  uint64_t columns[64] = {0};
+  std::copy(visible, visible + diameter, columns);
+  transpose(columns);
+  int count = 0;
+  for (int x = 0; x < diameter; ++x)
+    count += __builtin_popcountll(columns[x]);
+  vector<Vec2> ret;
+  ret.reserve(count);
+  for (int x = 0; x < diameter; ++x)
+    for (uint64_t column = columns[x]; column; column &= column - 1)
+      ret.push_back(Vec2(px + x - sightRange, py + __builtin_ctzll(column) - sightRange));
+  return ret;
+}
+
+size_t FieldOfView::Visibility::getMemoryUsage() const {
+  return sizeof(Visibility);
+}
+
+Vec2 FieldOfView::Visibility::getPosition() const {
+  return Vec2(px, py);
+}
+
+vector<Vec2> FieldOfView::getVisibleTiles(Vec2 from) {
+  return useVisibility(from).getVisibleTiles();
+}
+
+
 bool FieldOfView::Visibility::checkVisible(int x, int y) const {
   return x >= -sightRange && y >= -sightRange && x <= sightRange && y <= sightRange && 
-    visible[sightRange + x][sightRange + y] == 1;
+    ((visible[sightRange + y] >> (sightRange + x)) & 1);
 }
 
 
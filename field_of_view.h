@@ -21,48 +21,82 @@
 class Square;
 class Vision;
 
+/** Caches the squares visible from each position. Only a limited number of positions is kept, the least
+    recently used ones are dropped when the memory budget is exceeded. Because of that, queries aren't
+    read-only: they compute missing entries and move the ones they use to the front of the cache.*/
 class FieldOfView {
   public:
-  FieldOfView(const Table<PSquare>& squares, Vision*);
+  FieldOfView(const Table<PSquare>& squares, Vision*, size_t memoryBudget = defaultMemoryBudget);
+
+  /** Creates a field of view for a map given only by the squares that block sight.*/
+  FieldOfView(const Table<bool>& opaque, size_t memoryBudget = defaultMemoryBudget);
+
+  /** Updates the cache, see the class comment.*/
   bool canSee(Vec2 from, Vec2 to);
-  const vector<Vec2>& getVisibleTiles(Vec2 from);
+
+  /** Updates the cache, see the class comment. Returns a copy, as the entry may be dropped by the next query.*/
+  vector<Vec2> getVisibleTiles(Vec2 from);
+
   void squareChanged(Vec2 pos);
 
-  SERIALIZATION_DECL(FieldOfView);
+  struct CacheStats {
+    long long hits;
+    long long misses;
+    long long evictions;
+  };
+
+  const CacheStats& getCacheStats() const;
 
   const static int sightRange = 30;
+  /** An entry takes about 500 bytes, so the default budget keeps about 16000 positions.*/
+  const static size_t defaultMemoryBudget = 8 * 1024 * 1024;
 
   private:
 
-
   class Visibility {
     public:
 
     bool checkVisible(int x,int y) const;
-    const vector<Vec2>& getVisibleTiles() const;
-
-    Visibility(const Table<PSquare>& squares, Vision*, int x, int y);
-    Visibility(Visibility&&) = default;
-    Visibility& operator = (Visibility&&) = default;
+    vector<Vec2> getVisibleTiles() const;
+    Vec2 getPosition() const;
+    size_t getMemoryUsage() const;
 
-    SERIALIZATION_DECL(Visibility);
+    Visibility(const FieldOfView&, int x, int y);
 
     private:
-    char visible[sightRange * 2 + 1][sightRange * 2 + 1];
-    SERIAL3(visible);
-    vector<Vec2> SERIAL(visibleTiles);
-    void calculate(int,int,int,int, int, int, int, int,
-        function<bool (int, int)> isBlocking,
-        function<void (int, int)> setVisible);
-    void setVisible(int, int);
-
-    int SERIAL(px);
-    int SERIAL(py);
+    const static int diameter = sightRange * 2 + 1;
+    static_assert(diameter <= 64, "A row of the visible area must fit in a 64 bit word");
+    /** Bit sightRange + x of visible[sightRange + y] is set if the square at offset (x, y) is visible.*/
+    uint64_t visible[diameter];
+
+    int px;
+    int py;
   };
-  
-  const Table<PSquare>* SERIAL(squares);
-  Table<Optional<Visibility>> SERIAL(visibility);
-  Vision* SERIAL(vision);
+
+  /** Returns the visibility from the position, computing it if it's missing, and makes it the most recently
+      used entry.*/
+  Visibility& useVisibility(Vec2 pos);
+  void erase(std::list<Visibility>::iterator);
+  /** Bit i is set if the square (x + i, y) blocks sight, for i < length <= 64. Squares outside are opaque.*/
+  uint64_t getOpaqueRow(int x, int y, int length) const;
+  /** Bit i is set if the square (x, y + i) blocks sight, for i < length <= 64. Squares outside are opaque.*/
+  uint64_t getOpaqueColumn(int x, int y, int length) const;
+  void setOpaque(Vec2 pos, bool);
+
+  const Table<PSquare>* squares = nullptr;
+  Vision* vision = nullptr;
+  /** One bit per square of the level, set if the square blocks sight. Squares outside are opaque.*/
+  int width;
+  int height;
+  vector<uint64_t> opaque;
+  /** The same bits stored column by column, so that columns can be read a word at a time.*/
+  vector<uint64_t> opaqueColumns;
+  /** Most recently used entries are at the front.*/
+  std::list<Visibility> visibility;
+  unordered_map<Vec2, std::list<Visibility>::iterator> cached;
+  size_t memoryBudget;
+  size_t memoryUsed = 0;
+  CacheStats stats {0, 0, 0};
 };
 
 #endif
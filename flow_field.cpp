@@ -0,0 +1,122 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+
+#include "flow_field.h"
+#include "shortest_path.h"
+
+static int areaIdCounter = 0;
+
+DestinationArea::DestinationArea(vector<Vec2> s) : squares(s), id(++areaIdCounter) {
+}
+
+const vector<Vec2>& DestinationArea::getSquares() const {
+  return squares;
+}
+
+int DestinationArea::getId() const {
+  return id;
+}
+
+FlowField::FlowField(Rectangle bounds, const vector<Vec2>& targets, function<double(Vec2)> fun)
+    : entryFun(fun), distance(bounds, ShortestPath::infinity), done(bounds, false) {
+  for (Vec2 v : targets) {
+    distance[v] = 0;
+    frontier.push({v, 0});
+  }
+}
+
+void FlowField::expand(Vec2 pos) {
+  // Squares are finished in the order of increasing distance, so when pos is done, all squares closer to
+  // the targets are done as well.
+  while (!done[pos] && !frontier.empty()) {
+    QueueElem cur = frontier.top();
+    frontier.pop();
+    if (done[cur.pos])
+      continue;
+    done[cur.pos] = true;
+    // The distance of a neighbor is the cost of stepping from it onto cur and then following the field.
+    double dist = cur.dist + entryFun(cur.pos);
+    for (Vec2 v : cur.pos.neighbors8())
+      if (v.inRectangle(distance.getBounds()) && !done[v] && dist < distance[v]
+          && entryFun(v) < ShortestPath::infinity) {
+        distance[v] = dist;
+        frontier.push({v, dist});
+      }
+  }
+}
+
+bool FlowField::isReachable(Vec2 pos) {
+  expand(pos);
+  return done[pos];
+}
+
+double FlowField::getDistance(Vec2 pos) {
+  expand(pos);
+  return done[pos] ? distance[pos] : ShortestPath::infinity;
+}
+
+vector<Vec2> FlowField::getNextMoves(Vec2 pos) {
+  vector<Vec2> ret;
+  if (!isReachable(pos))
+    return ret;
+  vector<pair<double, Vec2>> moves;
+  for (Vec2 v : pos.neighbors8())
+    if (v.inRectangle(distance.getBounds()) && done[v] && distance[v] < distance[pos])
+      moves.emplace_back(entryFun(v) + distance[v], v);
+  std::stable_sort(moves.begin(), moves.end(),
+      [] (const pair<double, Vec2>& a, const pair<double, Vec2>& b) { return a.first < b.first; });
+  for (auto& move : moves)
+    ret.push_back(move.second);
+  return ret;
+}
+
+bool FlowField::isAffectedBy(Vec2 pos) const {
+  if (distance[pos] < ShortestPath::infinity)
+    return true;
+  for (Vec2 v : pos.neighbors8())
+    if (v.inRectangle(distance.getBounds()) && done[v])
+      return true;
+  return false;
+}
+
+const int maxCachedFields = 30;
+
+FlowField& FlowFieldCache::get(const DestinationArea& area, const MovementType& movement, Rectangle bounds,
+    function<double(Vec2)> entryFun) {
+  auto key = make_pair(area.getId(), movement);
+  if (!fields.count(key)) {
+    if (fields.size() >= maxCachedFields) {
+      auto oldest = fields.begin();
+      for (auto it = fields.begin(); it != fields.end(); ++it)
+        if (it->second.lastUsed < oldest->second.lastUsed)
+          oldest = it;
+      fields.erase(oldest);
+    }
+    fields[key].field.reset(new FlowField(bounds, area.getSquares(), entryFun));
+  }
+  Entry& entry = fields.at(key);
+  entry.lastUsed = ++useCounter;
+  return *entry.field;
+}
+
+void FlowFieldCache::squareChanged(Vec2 pos) {
+  for (auto it = fields.begin(); it != fields.end();)
+    if (it->second.field->isAffectedBy(pos))
+      it = fields.erase(it);
+    else
+      ++it;
+}
@@ -0,0 +1,86 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _FLOW_FIELD_H
+#define _FLOW_FIELD_H
+
+#include "util.h"
+#include "movement_type.h"
+
+/** Squares that many creatures are heading to, eg. a storage. An area gets a new id whenever its squares
+    change, so the flow fields leading to it can be kept by id. The ids are unique within the process, so
+    the areas of all collectives can share the cache of a level. Neither is saved, so the ids never have
+    to survive a reload.*/
+class DestinationArea {
+  public:
+  DestinationArea(vector<Vec2> squares);
+  const vector<Vec2>& getSquares() const;
+  int getId() const;
+
+  private:
+  vector<Vec2> squares;
+  int id;
+};
+
+/** Costs of reaching every square from the closest of a set of targets, shared by all creatures with
+    the same movement type that are heading there. The costs should depend on the terrain only, creatures
+    move all the time and the field would go stale. The search is expanded lazily, only as far as the
+    queried positions.*/
+class FlowField {
+  public:
+  FlowField(Rectangle bounds, const vector<Vec2>& targets, function<double(Vec2)> entryFun);
+
+  /** Returns the neighbors of \paramname{pos} that are closer to the targets, the cheapest way first.
+      Returns an empty vector if no target can be reached.*/
+  vector<Vec2> getNextMoves(Vec2 pos);
+  bool isReachable(Vec2 pos);
+  double getDistance(Vec2 pos);
+
+  /** Checks if changing the square at \paramname{pos} could invalidate the computed distances.*/
+  bool isAffectedBy(Vec2 pos) const;
+
+  private:
+  void expand(Vec2 pos);
+
+  function<double(Vec2)> entryFun;
+  Table<double> distance;
+  Table<bool> done;
+  struct QueueElem {
+    Vec2 pos;
+    double dist;
+    bool operator < (const QueueElem& other) const {
+      return dist > other.dist;
+    }
+  };
+  priority_queue<QueueElem> frontier;
+};
+
+/** Keeps the most recently used flow fields of a level and drops them when the level changes.*/
+class FlowFieldCache {
+  public:
+  FlowField& get(const DestinationArea&, const MovementType&, Rectangle bounds,
+      function<double(Vec2)> entryFun);
+  void squareChanged(Vec2 pos);
+
+  private:
+  struct Entry {
+    unique_ptr<FlowField> field;
+    int lastUsed;
+  };
+  map<pair<int, MovementType>, Entry> fields;
+  int useCounter = 0;
+};
+
+#endif
@@ -66,6 +66,14 @@ class GameInfo {
       double standing;
     };
     vector<Deity> deities;
+
+    /** Hashes of everything the right band sections are built from, set by updateHashes() once the
+        info is filled. GuiBuilder keeps a built section for as long as its hash doesn't change.*/
+    size_t minionsHash = 0;
+    size_t buildingsHash = 0;
+    size_t technologyHash = 0;
+    size_t deitiesHash = 0;
+    void updateHashes();
   } bandInfo;
 
   class PlayerInfo {
@@ -110,6 +118,8 @@ class GameInfo {
       string state;
     };
     vector<Village> villages;
+    size_t hash = 0;
+    void updateHash();
   } villageInfo;
 
   class SunlightInfo {
@@ -44,10 +44,23 @@ void GuiBuilder::reset() {
   chosenCreature = "";
   activeBuilding = 0;
   activeLibrary = -1;
+  for (CachedList* list : {&minionList, &buildingList, &technologyList, &deityList, &villageList,
+      &keeperHelpList})
+    *list = CachedList();
 }
 
 const int legendLineHeight = 30;
 
+PGuiElem GuiBuilder::getCachedList(CachedList& list, size_t hash, function<vector<PGuiElem>()> buildLines) {
+  if (!list.elem || list.hash != hash) {
+    vector<PGuiElem> lines = buildLines();
+    list.numLines = lines.size();
+    list.elem = GuiElem::verticalList(std::move(lines), legendLineHeight, 0);
+    list.hash = hash;
+  }
+  return GuiElem::external(list.elem.get());
+}
+
 PGuiElem GuiBuilder::getHintCallback(const string& s) {
   return GuiElem::mouseOverAction([this, s]() { callbacks.hintCallback(s); });
 }
@@ -157,8 +170,11 @@ vector<PGuiElem> GuiBuilder::drawButtons(vector<GameInfo::BandInfo::Button> butt
 }
 
 PGuiElem GuiBuilder::drawBuildings(GameInfo::BandInfo& info) {
-  return GuiElem::verticalList(drawButtons(info.buildings, activeBuilding, CollectiveTab::BUILDINGS),
-      legendLineHeight, 0);
+  size_t hash = info.buildingsHash;
+  combineHash(hash, activeBuilding);
+  combineHash(hash, tilesOk);
+  return getCachedList(buildingList, hash, [&] {
+      return drawButtons(info.buildings, activeBuilding, CollectiveTab::BUILDINGS); });
 }
 
 static PGuiElem getStandingGui(double standing) {
@@ -173,29 +189,36 @@ static PGuiElem getStandingGui(double standing) {
 }
 
 PGuiElem GuiBuilder::drawDeities(GameInfo::BandInfo& info) {
-  vector<PGuiElem> lines;
-  for (int i : All(info.deities)) {
-    lines.push_back(GuiElem::stack(
-          GuiElem::button(getButtonCallback(UserInput(UserInputId::DEITIES, i))),
-          GuiElem::label(capitalFirst(info.deities[i].name), colors[ColorId::WHITE])));
-    lines.push_back(GuiElem::margins(GuiElem::horizontalList(makeVec<PGuiElem>(
-              GuiElem::label("standing: ", colors[ColorId::WHITE]),
-              getStandingGui(info.deities[i].standing)), 85, 0), 40, 0, 0, 0));
-  }
-  return GuiElem::verticalList(std::move(lines), legendLineHeight, 0);
+  return getCachedList(deityList, info.deitiesHash, [&] {
+    vector<PGuiElem> lines;
+    for (int i : All(info.deities)) {
+      lines.push_back(GuiElem::stack(
+            GuiElem::button(getButtonCallback(UserInput(UserInputId::DEITIES, i))),
+            GuiElem::label(capitalFirst(info.deities[i].name), colors[ColorId::WHITE])));
+      lines.push_back(GuiElem::margins(GuiElem::horizontalList(makeVec<PGuiElem>(
+                GuiElem::label("standing: ", colors[ColorId::WHITE]),
+                getStandingGui(info.deities[i].standing)), 85, 0), 40, 0, 0, 0));
+    }
+    return lines;
+  });
 }
 
 PGuiElem GuiBuilder::drawTechnology(GameInfo::BandInfo& info) {
-  vector<PGuiElem> lines = drawButtons(info.libraryButtons, activeLibrary, CollectiveTab::TECHNOLOGY);
-  for (int i : All(info.techButtons)) {
-    vector<PGuiElem> line;
-    line.push_back(GuiElem::viewObject(ViewObject(info.techButtons[i].viewId, ViewLayer::CREATURE, ""), tilesOk));
-    line.push_back(GuiElem::label(info.techButtons[i].name, colors[ColorId::WHITE], info.techButtons[i].hotkey));
-    lines.push_back(GuiElem::stack(GuiElem::button(
-          getButtonCallback(UserInput(UserInputId::TECHNOLOGY, i)), info.techButtons[i].hotkey),
-          GuiElem::horizontalList(std::move(line), 35, 0)));
-  }
-  return GuiElem::verticalList(std::move(lines), legendLineHeight, 0);
+  size_t hash = info.technologyHash;
+  combineHash(hash, activeLibrary);
+  combineHash(hash, tilesOk);
+  return getCachedList(technologyList, hash, [&] {
+    vector<PGuiElem> lines = drawButtons(info.libraryButtons, activeLibrary, CollectiveTab::TECHNOLOGY);
+    for (int i : All(info.techButtons)) {
+      vector<PGuiElem> line;
+      line.push_back(GuiElem::viewObject(ViewObject(info.techButtons[i].viewId, ViewLayer::CREATURE, ""), tilesOk));
+      line.push_back(GuiElem::label(info.techButtons[i].name, colors[ColorId::WHITE], info.techButtons[i].hotkey));
+      lines.push_back(GuiElem::stack(GuiElem::button(
+            getButtonCallback(UserInput(UserInputId::TECHNOLOGY, i)), info.techButtons[i].hotkey),
+            GuiElem::horizontalList(std::move(line), 35, 0)));
+    }
+    return lines;
+  });
 }
 
 PGuiElem GuiBuilder::drawKeeperHelp() {
@@ -216,10 +239,12 @@ PGuiElem GuiBuilder::drawKeeperHelp() {
     "press mouse wheel: level map",
     "",
     "follow the orange hints :-)"};
-  vector<PGuiElem> lines;
-  for (string line : helpText)
-    lines.push_back(GuiElem::label(line, colors[ColorId::LIGHT_BLUE]));
-  return GuiElem::verticalList(std::move(lines), legendLineHeight, 0);
+  return getCachedList(keeperHelpList, 0, [&] {
+    vector<PGuiElem> lines;
+    for (string line : helpText)
+      lines.push_back(GuiElem::label(line, colors[ColorId::LIGHT_BLUE]));
+    return lines;
+  });
 }
 
 int GuiBuilder::FpsCounter::getSec() {
@@ -588,9 +613,8 @@ static map<string, CreatureMapElem> getCreatureMap(vector<CreatureInfo>& creatur
   return creatureMap;
 }
 
-PGuiElem GuiBuilder::drawMinions(GameInfo::BandInfo& info) {
+vector<PGuiElem> GuiBuilder::drawMinionList(GameInfo::BandInfo& info) {
   map<string, CreatureMapElem> creatureMap = getCreatureMap(info.minions);
-  map<string, CreatureMapElem> enemyMap = getCreatureMap(info.enemies);
   vector<PGuiElem> list;
   list.push_back(GuiElem::label(info.monsterHeader, colors[ColorId::WHITE]));
   for (auto elem : creatureMap){
@@ -656,6 +680,19 @@ PGuiElem GuiBuilder::drawMinions(GameInfo::BandInfo& info) {
         GuiElem::viewObject(ViewId::TEAM_BUTTON_HIGHLIGHT, tilesOk),
         GuiElem::label("Click on minions to add.", colors[ColorId::LIGHT_BLUE])), elemWidth, 0));
   list.push_back(GuiElem::empty());
+  return list;
+}
+
+PGuiElem GuiBuilder::drawMinions(GameInfo::BandInfo& info) {
+  if (!std::any_of(info.minions.begin(), info.minions.end(),
+        [&] (const CreatureInfo& c) { return c.speciesName == chosenCreature; }))
+    chosenCreature = "";
+  size_t hash = info.minionsHash;
+  combineHash(hash, chosenCreature);
+  combineHash(hash, tilesOk);
+  vector<PGuiElem> list;
+  list.push_back(getCachedList(minionList, hash, [&] { return drawMinionList(info); }));
+  vector<int> heights { minionList.numLines * legendLineHeight };
   if (info.payoutTimeRemaining > -1) {
     vector<PGuiElem> res;
     res.push_back(GuiElem::label("Next payout [" + toString(info.payoutTimeRemaining) + "]:",
@@ -665,6 +702,7 @@ PGuiElem GuiBuilder::drawMinions(GameInfo::BandInfo& info) {
     list.push_back(GuiElem::horizontalList(std::move(res), {170, 30, 1}, 0));
     list.push_back(GuiElem::empty());
   }
+  map<string, CreatureMapElem> enemyMap = getCreatureMap(info.enemies);
   if (!enemyMap.empty()) {
     list.push_back(GuiElem::label("Enemies:", colors[ColorId::WHITE]));
     for (auto elem : enemyMap){
@@ -674,10 +712,8 @@ PGuiElem GuiBuilder::drawMinions(GameInfo::BandInfo& info) {
       list.push_back(GuiElem::horizontalList(std::move(line), 20, 0));
     }
   }
-  if (!creatureMap.count(chosenCreature)) {
-    chosenCreature = "";
-  }
-  return GuiElem::verticalList(std::move(list), legendLineHeight, 0);
+  heights.resize(list.size(), legendLineHeight);
+  return GuiElem::verticalList(std::move(list), heights, 0);
 }
 
 const int minionWindowWidth = 300;
@@ -833,13 +869,15 @@ void GuiBuilder::drawMessages(vector<OverlayInfo>& ret,
 }
 
 PGuiElem GuiBuilder::drawVillages(GameInfo::VillageInfo& info) {
-  vector<PGuiElem> lines;
-  for (auto elem : info.villages) {
-    lines.push_back(GuiElem::label(capitalFirst(elem.name), colors[ColorId::WHITE]));
-    lines.push_back(GuiElem::margins(GuiElem::label("tribe: " + elem.tribeName, colors[ColorId::WHITE]), 40, 0, 0, 0));
-    if (!elem.state.empty())
-      lines.push_back(GuiElem::margins(GuiElem::label(elem.state, elem.state == "conquered" ? colors[ColorId::GREEN] : colors[ColorId::RED]),
-            40, 0, 0, 0));
-  }
-  return GuiElem::verticalList(std::move(lines), legendLineHeight, 0);
+  return getCachedList(villageList, info.hash, [&] {
+    vector<PGuiElem> lines;
+    for (auto elem : info.villages) {
+      lines.push_back(GuiElem::label(capitalFirst(elem.name), colors[ColorId::WHITE]));
+      lines.push_back(GuiElem::margins(GuiElem::label("tribe: " + elem.tribeName, colors[ColorId::WHITE]), 40, 0, 0, 0));
+      if (!elem.state.empty())
+        lines.push_back(GuiElem::margins(GuiElem::label(elem.state, elem.state == "conquered" ? colors[ColorId::GREEN] : colors[ColorId::RED]),
+              40, 0, 0, 0));
+    }
+    return lines;
+  });
 }
@@ -115,6 +115,21 @@ class GuiBuilder {
     sf::Clock clock;
   } fpsCounter;
 
+  struct CachedList {
+    size_t hash = 0;
+    PGuiElem elem;
+    int numLines = 0;
+  };
+  /** Returns a list of lines built by \paramname{buildLines}. The lines are rebuilt only if the hash is
+      different from the one they were last built with.*/
+  PGuiElem getCachedList(CachedList&, size_t hash, function<vector<PGuiElem>()> buildLines);
+  CachedList minionList;
+  CachedList buildingList;
+  CachedList technologyList;
+  CachedList deityList;
+  CachedList villageList;
+  CachedList keeperHelpList;
+  vector<PGuiElem> drawMinionList(GameInfo::BandInfo&);
   vector<PGuiElem> drawButtons(vector<GameInfo::BandInfo::Button> buttons, int& active, CollectiveTab);
   PGuiElem getButtonLine(GameInfo::BandInfo::Button, int num, int& active, CollectiveTab);
   void drawMinionsOverlay(vector<OverlayInfo>&, GameInfo::BandInfo&);
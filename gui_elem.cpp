@@ -542,6 +542,50 @@ PGuiElem GuiElem::invisible(PGuiElem content) {
   return PGuiElem(new Invisible(std::move(content)));
 }
 
+class External : public GuiElem {
+  public:
+  External(GuiElem* e) : elem(e) {}
+
+  virtual void render(Renderer& r) override {
+    elem->render(r);
+  }
+
+  virtual bool onLeftClick(Vec2 pos) override {
+    return elem->onLeftClick(pos);
+  }
+
+  virtual bool onRightClick(Vec2 pos) override {
+    return elem->onRightClick(pos);
+  }
+
+  virtual void onMouseMove(Vec2 pos) override {
+    elem->onMouseMove(pos);
+  }
+
+  virtual void onMouseRelease() override {
+    elem->onMouseRelease();
+  }
+
+  virtual void onRefreshBounds() override {
+    elem->setBounds(getBounds());
+  }
+
+  virtual void onKeyPressed(char key) override {
+    elem->onKeyPressed(key);
+  }
+
+  virtual void onKeyPressed2(Event::KeyEvent key) override {
+    elem->onKeyPressed2(key);
+  }
+
+  private:
+  GuiElem* elem;
+};
+
+PGuiElem GuiElem::external(GuiElem* elem) {
+  return PGuiElem(new External(elem));
+}
+
 class Switchable : public GuiLayout {
   public:
   Switchable(vector<PGuiElem> elems, function<int()> fun) : GuiLayout(std::move(elems)), switchFun(fun) {}
@@ -933,7 +977,7 @@ void GuiElem::changeBackground(int r, int g, int b) {
   background1.g += g;
   background1.b += b;
   background2 = background1;
-  Debug() << "New color " << background1.r << " " << background1.g << " " << background1.b << " ";
+  LOG(INFO, GUI) << "New color " << background1.r << " " << background1.g << " " << background1.b << " ";
 }
 
 void GuiElem::setBackground(int r, int g, int b) {
@@ -941,7 +985,7 @@ void GuiElem::setBackground(int r, int g, int b) {
   background1.g = g;
   background1.b = b;
   background2 = background1;
-  Debug() << "New color " << background1.r << " " << background1.g << " " << background1.b << " ";
+  LOG(INFO, GUI) << "New color " << background1.r << " " << background1.g << " " << background1.b << " ";
 }
 
 static PGuiElem getScrollbar() {
@@ -93,6 +93,8 @@ class GuiElem {
   static PGuiElem border2(PGuiElem content);
   static PGuiElem mainDecoration(int rightBarWidth, int bottomBarHeight);
   static PGuiElem invisible(PGuiElem content);
+  /** Forwards everything to an element owned elsewhere, which must outlive the returned one.*/
+  static PGuiElem external(GuiElem*);
   static PGuiElem background(PGuiElem content, Color);
   static PGuiElem translucentBackground(PGuiElem content);
   static Color translucentBgColor;
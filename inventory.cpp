@@ -79,6 +79,10 @@ vector<Item*> Inventory::getItems() const {
   return itemsCache;
 }
 
+const vector<Item*>& Inventory::getAllItems() const {
+  return itemsCache;
+}
+
 bool Inventory::hasItem(const Item* itemRef) const {
   for (const PItem& item : items) 
     if (item.get() == itemRef)
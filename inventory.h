@@ -32,6 +32,8 @@ class Inventory {
 
   vector<Item*> getItems() const;
   vector<Item*> getItems(function<bool (Item*)> predicate) const;
+  /** Returns the items without copying them, so the inventory mustn't change while they are iterated.*/
+  const vector<Item*>& getAllItems() const;
 
   bool hasItem(const Item*) const;
   int size() const;
@@ -115,8 +115,100 @@ vector<pair<string, vector<Item*>>> Item::stackItems(vector<Item*> items, functi
   return ret;
 }
 
+size_t Item::getStackKey() const {
+  size_t ret = hash<string>()(*name);
+  if (isIdentified(*name) && realName)
+    combineHash(ret, *realName);
+  combineHash(ret, inspected);
+  combineHash(ret, fire.isBurning());
+  combineHash(ret, getShopkeeper() ? getPrice() : -1);
+  if (inspected) {
+    combineHash(ret, uses > -1 && displayUses ? uses : -1);
+    combineHash(ret, int(getClass()));
+    if (artifactName)
+      combineHash(ret, *artifactName);
+    for (auto mod : ENUM_ALL(ModifierType))
+      combineHash(ret, modifiers[mod]);
+    for (auto attr : ENUM_ALL(AttrType))
+      combineHash(ret, attrs[attr]);
+  }
+  return ret;
+}
+
+static bool sameOptional(const Optional<string>& a, const Optional<string>& b) {
+  return bool(a) == bool(b) && (!a || *a == *b);
+}
+
+bool Item::canStackWith(const Item* other) const {
+  if (*name != *other->name || inspected != other->inspected || fire.isBurning() != other->fire.isBurning()
+      || (getShopkeeper() ? getPrice() : -1) != (other->getShopkeeper() ? other->getPrice() : -1))
+    return false;
+  if (isIdentified(*name) && !sameOptional(realName, other->realName))
+    return false;
+  if (inspected) {
+    if ((uses > -1 && displayUses ? uses : -1) != (other->uses > -1 && other->displayUses ? other->uses : -1)
+        || getClass() != other->getClass() || !sameOptional(artifactName, other->artifactName))
+      return false;
+    for (auto mod : ENUM_ALL(ModifierType))
+      if (modifiers[mod] != other->modifiers[mod])
+        return false;
+    for (auto attr : ENUM_ALL(AttrType))
+      if (attrs[attr] != other->attrs[attr])
+        return false;
+  }
+  return true;
+}
+
+void ItemStacks::reset(const vector<Item*>& elems) {
+  keys.clear();
+  for (int i : All(elems))
+    keys.emplace_back(elems[i]->getStackKey(), i);
+  // Ties are broken by the original position, so the grouping doesn't depend on pointer values.
+  std::sort(keys.begin(), keys.end());
+  items.clear();
+  stackEnds.clear();
+  for (int i : All(keys))
+    items.push_back(elems[keys[i].second]);
+  // Items with equal keys are next to each other, but a hash collision can still mix different items, so
+  // within a run of equal keys the items that really stack are moved to the front of the run.
+  for (int begin = 0; begin < items.size();) {
+    int end = begin + 1;
+    for (int j = begin + 1; j < keys.size() && keys[j].first == keys[begin].first; ++j)
+      if (items[j]->canStackWith(items[begin])) {
+        std::rotate(items.begin() + end, items.begin() + j, items.begin() + j + 1);
+        std::rotate(keys.begin() + end, keys.begin() + j, keys.begin() + j + 1);
+        ++end;
+      }
+    stackEnds.push_back(end);
+    begin = end;
+  }
+}
+
+int ItemStacks::getNumStacks() const {
+  return stackEnds.size();
+}
+
+Item* ItemStacks::getFirst(int stack) const {
+  return items[stack > 0 ? stackEnds[stack - 1] : 0];
+}
+
+int ItemStacks::getSize(int stack) const {
+  return stackEnds[stack] - (stack > 0 ? stackEnds[stack - 1] : 0);
+}
+
+double ItemStacks::getWeight(int stack) const {
+  double ret = 0;
+  for (int i = stackEnds[stack] - getSize(stack); i < stackEnds[stack]; ++i)
+    ret += items[i]->getWeight();
+  return ret;
+}
+
+vector<Item*> ItemStacks::getItems(int stack) const {
+  return vector<Item*>(items.begin() + stackEnds[stack] - getSize(stack), items.begin() + stackEnds[stack]);
+}
+
 void Item::identify(const string& name) {
-  Debug() << "Identify " << name;
+  LOG(INFO, ITEM) << "Identify " << name;
   ident.insert(name);
 }
 
@@ -159,7 +251,7 @@ double Item::getFireSize() const {
 
 void Item::tick(double time, Level* level, Vec2 position) {
   if (fire.isBurning()) {
-    Debug() << getName() << " burning " << fire.getSize();
+    LOG(TRACE, ITEM) << getName() << " burning " << fire.getSize();
     level->getSafeSquare(position)->setOnFire(fire.getSize());
     modViewObject().setAttribute(ViewObject::Attribute::BURNING, fire.getSize());
     fire.tick(level, position);
@@ -79,6 +79,11 @@ class Item : private ItemAttributes, public Renderable, public UniqueEntity<Item
   string getTheName(bool plural = false, bool blind = false) const;
   string getAName(bool plural = false, bool blind = false) const;
   string getNameAndModifiers(bool plural = false, bool blind = false) const;
+  /** Items with equal keys have the same getNameAndModifiers() and stack together. Unlike the name,
+      the key is computed without formatting any strings.*/
+  size_t getStackKey() const;
+  /** Compares everything that getStackKey() hashes, to tell apart items whose keys collide.*/
+  bool canStackWith(const Item*) const;
   string getArtifactName() const;
 
   virtual Optional<EffectType> getEffectType() const;
@@ -164,4 +169,21 @@ class Item : private ItemAttributes, public Renderable, public UniqueEntity<Item
   Fire SERIAL(fire);
 };
 
+/** Groups items by Item::getStackKey() and Item::canStackWith(), for code that needs the stacks but not their names. The buffers
+    are kept between calls, so regrouping doesn't allocate once they are big enough.*/
+class ItemStacks {
+  public:
+  void reset(const vector<Item*>&);
+  int getNumStacks() const;
+  Item* getFirst(int stack) const;
+  int getSize(int stack) const;
+  double getWeight(int stack) const;
+  vector<Item*> getItems(int stack) const;
+
+  private:
+  vector<pair<size_t, int>> keys;
+  vector<Item*> items;
+  vector<int> stackEnds;
+};
+
 #endif
@@ -340,7 +340,7 @@ class Potion : public Item {
 
   virtual void setOnFire(double amount, const Level* level, Vec2 position) override {
     heat += amount;
-    Debug() << getName() << " heat " << heat;
+    LOG(TRACE, ITEM) << getName() << " heat " << heat;
     if (heat > 0.1) {
       level->globalMessage(position, getAName() + " boils and explodes!");
       discarded = true;
@@ -888,11 +888,11 @@ void makeArtifact(ItemAttributes& i) {
     for (auto elem : badArtifactNames)
       for (auto pattern : elem.second)
         if (contains(toLower(*i.artifactName), pattern) && contains(*i.name, elem.first)) {
-          Debug() << "Rejected artifact " << *i.name << " " << *i.artifactName;
+          LOG(INFO, ITEM) << "Rejected artifact " << *i.name << " " << *i.artifactName;
           good = false;
         }
   } while (!good);
-  Debug() << "Making artifact " << *i.name << " " << *i.artifactName;
+  LOG(INFO, ITEM) << "Making artifact " << *i.name << " " << *i.artifactName;
   i.modifiers[ModifierType::DAMAGE] += Random.get(1, 4);
   i.modifiers[ModifierType::ACCURACY] += Random.get(1, 4);
   i.price *= 15;
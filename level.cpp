@@ -24,6 +24,7 @@
 #include "collective_builder.h"
 #include "trigger.h"
 #include "progress_meter.h"
+#include "shortest_path.h"
 
 template <class Archive> 
 void Level::serialize(Archive& ar, const unsigned int version) {
@@ -34,15 +35,12 @@ void Level::serialize(Archive& ar, const unsigned int version) {
     & SVAR(tickingSquares)
     & SVAR(creatures)
     & SVAR(model)
-    & SVAR(fieldOfView)
     & SVAR(entryMessage)
     & SVAR(name)
     & SVAR(player)
     & SVAR(backgroundLevel)
     & SVAR(backgroundOffset)
-    & SVAR(coverInfo)
-    & SVAR(bucketMap)
-    & SVAR(lightAmount);
+    & SVAR(coverInfo);
   CHECK_SERIAL;
 }  
 
@@ -54,9 +52,7 @@ Level::~Level() {}
 
 Level::Level(Table<PSquare> s, Model* m, vector<Location*> l, const string& message, const string& n,
     Table<CoverInfo> covers) 
-    : squares(std::move(s)), locations(l), model(m), entryMessage(message), name(n), coverInfo(std::move(covers)),
-      bucketMap(squares.getBounds().getW(), squares.getBounds().getH(), FieldOfView::sightRange),
-      lightAmount(squares.getBounds(), 0) {
+    : squares(std::move(s)), locations(l), model(m), entryMessage(message), name(n), coverInfo(std::move(covers)) {
   for (Vec2 pos : squares.getBounds()) {
     squares[pos]->setLevel(this);
     Optional<pair<StairDirection, StairKey>> link = squares[pos]->getLandingLink();
@@ -67,8 +63,8 @@ Level::Level(Table<PSquare> s, Model* m, vector<Location*> l, const string& mess
     l->setLevel(this);
   for (Vision* vision : Vision::getAll())
     fieldOfView.emplace(vision, FieldOfView(squares, vision));
-  for (Vec2 pos : squares.getBounds())
-    addLightSource(pos, squares[pos]->getLightEmission(), 1);
+  getBucketMap();
+  getLightAmount();
 }
 
 Rectangle Level::getMaxBounds() {
@@ -83,9 +79,9 @@ void Level::addCreature(Vec2 position, PCreature c) {
 
 void Level::putCreature(Vec2 position, Creature* c) {
   CHECK(inBounds(position));
-  creatures.push_back(c);
   CHECK(getSafeSquare(position)->getCreature() == nullptr);
-  bucketMap.addElement(position, c);
+  getBucketMap().addElement(position, c);
+  creatures.push_back(c);
   c->setLevel(this);
   c->setPosition(position);
   //getSquare(position)->putCreatureSilently(c);
@@ -108,13 +104,73 @@ void Level::removeLightSource(Vec2 pos, double radius) {
 }
 
 void Level::addLightSource(Vec2 pos, double radius, int numLight) {
-  if (radius > 0) {
-    for (Vec2 v : getVisibleTilesNoDarkness(pos, Vision::get(VisionId::NORMAL))) {
-      double dist = (v - pos).lengthD();
-      if (dist <= radius)
-        lightAmount[v] += min(1.0, 1 - (dist) / radius) * numLight;
+  // If the light isn't computed yet, the current light sources will be included once it is.
+  if (!lightAmount || radius <= 0)
+    return;
+  PROFILE_ZONE("lighting");
+  vector<LightSource>& sources = lightSources[pos];
+  auto source = std::find_if(sources.begin(), sources.end(),
+      [radius](const LightSource& s) { return s.radius == radius; });
+  if (source == sources.end()) {
+    if (numLight < 0) {
+      addLight(pos, {radius, 0, getLitSquares(pos, radius)}, numLight);
+      return;
+    }
+    sources.push_back({radius, 0, getLitSquares(pos, radius)});
+    source = sources.end() - 1;
+  }
+  addLight(pos, *source, numLight);
+  source->count += numLight;
+  if (source->count <= 0)
+    sources.erase(source);
+  if (sources.empty())
+    lightSources.erase(pos);
+  int r = ceil(radius);
+  GlobalEvents.addVisibilityChangedEvent(this, Rectangle(pos - Vec2(r, r), pos + Vec2(r + 1, r + 1)));
+}
+
+vector<pair<Vec2, double>> Level::getLitSquares(Vec2 pos, double radius) const {
+  vector<pair<Vec2, double>> ret;
+  for (Vec2 v : getVisibleTilesNoDarkness(pos, Vision::get(VisionId::NORMAL))) {
+    double dist = (v - pos).lengthD();
+    if (dist <= radius)
+      ret.emplace_back(v, min(1.0, 1 - (dist) / radius));
+  }
+  return ret;
+}
+
+void Level::addLight(Vec2 pos, const LightSource& source, int numLight) const {
+  for (auto& elem : source.lit)
+    (*lightAmount)[elem.first] += elem.second * numLight;
+  int radius = ceil(source.radius);
+  markChanged(Rectangle(pos - Vec2(radius, radius), pos + Vec2(radius + 1, radius + 1)));
+}
+
+Table<double>& Level::getLightAmount() const {
+  if (!lightAmount) {
+    PROFILE_ZONE("lighting");
+    lightAmount.reset(new Table<double>(squares.getBounds(), 0));
+    lightSources.clear();
+    // All sources are gathered in a single sweep over the level.
+    for (Vec2 pos : squares.getBounds()) {
+      double radius = squares[pos]->getLightEmission();
+      if (radius > 0) {
+        lightSources[pos].push_back({radius, 1, getLitSquares(pos, radius)});
+        addLight(pos, lightSources[pos].back(), 1);
+      }
     }
   }
+  return *lightAmount;
+}
+
+BucketMap<Creature*>& Level::getBucketMap() const {
+  if (!bucketMap) {
+    bucketMap.reset(new BucketMap<Creature*>(squares.getBounds().getW(), squares.getBounds().getH(),
+          FieldOfView::sightRange));
+    for (Creature* c : creatures)
+      bucketMap->addElement(c->getPosition(), c);
+  }
+  return *bucketMap;
 }
 
 void Level::replaceSquare(Vec2 pos, PSquare square) {
@@ -134,15 +190,75 @@ void Level::replaceSquare(Vec2 pos, PSquare square) {
   }
   addLightSource(pos, squares[pos]->getLightEmission(), 1);
   updateVisibility(pos);
+  updatePathCaches(pos);
+}
+
+FlowField& Level::getFlowField(const DestinationArea& area, const MovementType& movement) const {
+  // Terrain costs of ShortestPath. Creatures are left out, as the field is only dropped when a square
+  // changes. Whoever follows the field checks if the next square is occupied.
+  auto entryFun = [this, movement] (Vec2 pos) {
+    const Square* square = getSafeSquare(pos);
+    if (square->canEnterEmpty(movement))
+      return 1.0;
+    if (square->canDestroy())
+      return 5.0;
+    return ShortestPath::infinity;
+  };
+  return flowFields.get(area, movement, getBounds(), entryFun);
+}
+
+PathGraph& Level::getPathGraph(const MovementType& movement) const {
+  // Squares restricted to a tribe count as passable, so all tribes with the same movement traits share
+  // a graph. Creatures that can't pass them find out when the path is refined.
+  MovementType key = movement.getWithoutTribe();
+  if (!pathGraphs.count(key))
+    pathGraphs[key].reset(new PathGraph(getBounds(), [this, key] (Vec2 pos) {
+        // Doors and other destructible obstacles are left passable, creatures break through them when needed.
+        const Square* square = getSafeSquare(pos);
+        return square->canEnterEmpty(key) || square->canDestroy();
+    }));
+  return *pathGraphs.at(key);
+}
+
+void Level::updatePathCaches(Vec2 pos) {
+  flowFields.squareChanged(pos);
+  for (auto& elem : pathGraphs)
+    elem.second->squareChanged(pos);
 }
 
 void Level::updateVisibility(Vec2 changedSquare) {
-  for (Vec2 pos : getVisibleTilesNoDarkness(changedSquare, Vision::get(VisionId::NORMAL)))
-    addLightSource(pos, squares[pos]->getLightEmission(), -1);
+  PROFILE_ZONE("lighting");
+  // A square can only shadow squares farther from the source than itself, so only the sources that
+  // reach it have to be recomputed.
+  vector<pair<Vec2, LightSource*>> affected;
+  if (lightAmount)
+    for (auto& elem : lightSources)
+      for (LightSource& source : elem.second)
+        if ((elem.first - changedSquare).lengthD() <= source.radius + 1) {
+          addLight(elem.first, source, -source.count);
+          affected.emplace_back(elem.first, &source);
+        }
   for (auto& elem : fieldOfView)
     elem.second.squareChanged(changedSquare);
-  for (Vec2 pos : getVisibleTilesNoDarkness(changedSquare, Vision::get(VisionId::NORMAL)))
-    addLightSource(pos, squares[pos]->getLightEmission(), 1);
+  for (auto& elem : affected) {
+    elem.second->lit = getLitSquares(elem.first, elem.second->radius);
+    addLight(elem.first, *elem.second, elem.second->count);
+  }
+  // Viewers that see differently now mark their own sight range, see VisibilityChangedEvent.
+  markChanged(changedSquare);
+  GlobalEvents.addVisibilityChangedEvent(this, Rectangle(changedSquare, changedSquare + Vec2(1, 1)));
+}
+
+void Level::markChanged(Rectangle area) const {
+  changes.add(area);
+}
+
+void Level::markChanged(Vec2 pos) const {
+  markChanged(Rectangle(pos, pos + Vec2(1, 1)));
+}
+
+Optional<vector<Rectangle>> Level::getChanges(const void* reader) const {
+  return changes.getSince(reader);
 }
 
 const Creature* Level::getPlayer() const {
@@ -173,7 +289,7 @@ double Level::getSunlight(Vec2 pos) const {
 }
 
 double Level::getLight(Vec2 pos) const {
-  return max(0.0, min(1.0, lightAmount[pos] + getSunlight(pos)));
+  return max(0.0, min(1.0, getLightAmount()[pos] + getSunlight(pos)));
 }
 
 vector<Vec2> Level::getLandingSquares(StairDirection dir, StairKey key) const {
@@ -257,7 +373,7 @@ void Level::throwItem(vector<PItem> item, const Attack& attack, int maxDist, Vec
 }
 
 void Level::killCreature(Creature* creature) {
-  bucketMap.removeElement(creature->getPosition(), creature);
+  getBucketMap().removeElement(creature->getPosition(), creature);
   removeElement(creatures, creature);
   getSafeSquare(creature->getPosition())->removeCreature();
   model->removeCreature(creature);
@@ -289,7 +405,7 @@ void Level::changeLevel(StairDirection dir, StairKey key, Creature* c) {
   Vec2 fromPosition = c->getPosition();
   removeElement(creatures, c);
   getSafeSquare(c->getPosition())->removeCreature();
-  bucketMap.removeElement(c->getPosition(), c);
+  getBucketMap().removeElement(c->getPosition(), c);
   Vec2 toPosition = model->changeLevel(dir, key, c);
   GlobalEvents.addChangeLevelEvent(c, this, fromPosition, c->getLevel(), toPosition);
 }
@@ -298,7 +414,7 @@ void Level::changeLevel(Level* destination, Vec2 landing, Creature* c) {
   Vec2 fromPosition = c->getPosition();
   removeElement(creatures, c);
   getSafeSquare(c->getPosition())->removeCreature();
-  bucketMap.removeElement(c->getPosition(), c);
+  getBucketMap().removeElement(c->getPosition(), c);
   model->changeLevel(destination, landing, c);
   GlobalEvents.addChangeLevelEvent(c, this, fromPosition, destination, landing);
 }
@@ -319,16 +435,46 @@ vector<Creature*>& Level::getAllCreatures() {
 }
 
 vector<Creature*> Level::getAllCreatures(Rectangle bounds) const {
-  return bucketMap.getElements(bounds);
+  return getBucketMap().getElements(bounds);
+}
+
+void Level::forEachCreature(Rectangle bounds, function<void(Creature*)> fun) const {
+  getBucketMap().visit(bounds, fun);
+}
+
+vector<Creature*> Level::getClosestCreatures(Vec2 pos, int maxDist, int num,
+    function<bool(const Creature*)> predicate) const {
+  return getBucketMap().getNearest(pos, maxDist, num, predicate);
 }
 
 const int darkViewRadius = 5;
+const double darkLight = 0.3;
 
 bool Level::isWithinVision(Vec2 from, Vec2 to, Vision* v) const {
-  return v->isNightVision() || from.distD(to) <= darkViewRadius || getLight(to) > 0.3;
+  return v->isNightVision() || from.distD(to) <= darkViewRadius || getLight(to) > darkLight;
+}
+
+void Level::updateSunlight(double previousAmount) {
+  markChanged(getBounds());
+  double amount = model->getSunlightInfo().lightAmount;
+  Vec2 from(getBounds().getKX(), getBounds().getKY());
+  Vec2 to(getBounds().getPX() - 1, getBounds().getPY() - 1);
+  for (Vec2 v : getBounds()) {
+    double sunlight = coverInfo[v].sunlight();
+    double before = max(0.0, min(1.0, getLightAmount()[v] + sunlight * previousAmount));
+    double after = max(0.0, min(1.0, getLightAmount()[v] + sunlight * amount));
+    if ((before > darkLight) != (after > darkLight)) {
+      from = Vec2(min(from.x, v.x), min(from.y, v.y));
+      to = Vec2(max(to.x, v.x), max(to.y, v.y));
+    }
+  }
+  if (from.x <= to.x)
+    GlobalEvents.addVisibilityChangedEvent(this, Rectangle(from, to + Vec2(1, 1)));
 }
 
 FieldOfView& Level::getFieldOfView(Vision* vision) const {
+  if (!fieldOfView.count(vision))
+    fieldOfView.emplace(vision, FieldOfView(squares, vision));
   return fieldOfView.at(vision);
 }
 
@@ -359,7 +505,7 @@ bool Level::canMoveCreature(const Creature* creature, Vec2 direction) const {
 void Level::moveCreature(Creature* creature, Vec2 direction) {
   CHECK(canMoveCreature(creature, direction));
   Vec2 position = creature->getPosition();
-  bucketMap.moveElement(position, position + direction, creature);
+  getBucketMap().moveElement(position, position + direction, creature);
   Square* nextSquare = getSafeSquare(position + direction);
   Square* thisSquare = getSafeSquare(position);
   thisSquare->removeCreature();
@@ -371,8 +517,8 @@ void Level::moveCreature(Creature* creature, Vec2 direction) {
 void Level::swapCreatures(Creature* c1, Creature* c2) {
   Vec2 position1 = c1->getPosition();
   Vec2 position2 = c2->getPosition();
-  bucketMap.moveElement(position1, position2, c1);
-  bucketMap.moveElement(position2, position1, c2);
+  getBucketMap().moveElement(position1, position2, c1);
+  getBucketMap().moveElement(position2, position1, c2);
   Square* square1 = getSafeSquare(position1);
   Square* square2 = getSafeSquare(position2);
   square1->removeCreature();
@@ -390,7 +536,7 @@ vector<Vec2> Level::getVisibleTilesNoDarkness(Vec2 pos, Vision* vision) const {
 }
 
 vector<Vec2> Level::getVisibleTiles(Vec2 pos, Vision* vision) const {
-  return filter(getFieldOfView(vision).getVisibleTiles(pos),
+  return filter(getVisibleTilesNoDarkness(pos, vision),
       [&](Vec2 v) { return isWithinVision(pos, v, vision); });
 }
 
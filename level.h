@@ -24,6 +24,8 @@
 #include "unique_entity.h"
 #include "bucket_map.h"
 #include "player_message.h"
+#include "flow_field.h"
+#include "path_graph.h"
 
 class Model;
 class Square;
@@ -101,6 +103,19 @@ class Level : public UniqueEntity<Level> {
       its obstructing/non-obstructing attribute. */
   void updateVisibility(Vec2 changedSquare);
 
+  /** Called when the amount of sunlight changes. Marks the level for repainting, and reports a visibility
+      change only where the light crossed the threshold of seeing in the dark.*/
+  void updateSunlight(double previousAmount);
+
+  /** Records that the squares in \paramname{area} may look different, so that views can refresh
+      only what has changed.*/
+  void markChanged(Rectangle area) const;
+  void markChanged(Vec2) const;
+
+  /** Returns the areas marked as changed since the previous call by \paramname{reader}.
+      Returns Nothing on the first call, or if the reader fell too far behind, and the whole view should be refreshed.*/
+  Optional<vector<Rectangle>> getChanges(const void* reader) const;
+
   /** Returns width of the level.*/
   int getWidth() const;
 
@@ -155,6 +170,14 @@ class Level : public UniqueEntity<Level> {
   const vector<Creature*>& getAllCreatures() const;
   vector<Creature*>& getAllCreatures();
   vector<Creature*> getAllCreatures(Rectangle bounds) const;
+
+  /** Calls \paramname{fun} on every creature inside the bounds without building a list.*/
+  void forEachCreature(Rectangle bounds, function<void(Creature*)> fun) const;
+
+  /** Returns up to \paramname{num} creatures within \paramname{maxDist} that satisfy the predicate,
+      closest first.*/
+  vector<Creature*> getClosestCreatures(Vec2 pos, int maxDist, int num,
+      function<bool(const Creature*)> predicate) const;
   //@}
 
   /** Checks whether the creature can see the square.*/
@@ -163,6 +186,17 @@ class Level : public UniqueEntity<Level> {
   /** Returns if it's possible to see the given square.*/
   bool canSee(Vec2 from, Vec2 to, Vision*) const;
 
+  /** Returns distances to the closest square of the area shared by all creatures with the given movement
+      type.*/
+  FlowField& getFlowField(const DestinationArea&, const MovementType&) const;
+
+  /** Returns the coarse map of the level used to plan long paths for the given movement type.*/
+  PathGraph& getPathGraph(const MovementType&) const;
+
+  /** Updates cached path data that could be affected by a change of movement rules on the square. Only
+      called by Square::setMovementType, replacing a square updates the caches by itself.*/
+  void updatePathCaches(Vec2);
+
   /** Returns all tiles visible by a creature.*/
   vector<Vec2> getVisibleTiles(const Creature*) const;
   vector<Vec2> getVisibleTiles(Vec2 pos, Vision*) const;
@@ -306,20 +340,36 @@ class Level : public UniqueEntity<Level> {
   set<Vec2> SERIAL(tickingSquares);
   vector<Creature*> SERIAL(creatures);
   Model* SERIAL2(model, nullptr);
-  mutable unordered_map<Vision*, FieldOfView> SERIAL(fieldOfView);
   string SERIAL(entryMessage);
   string SERIAL(name);
   Creature* SERIAL2(player, nullptr);
   const Level* SERIAL2(backgroundLevel, nullptr);
   Vec2 SERIAL(backgroundOffset);
   Table<CoverInfo> SERIAL(coverInfo);
-  BucketMap<Creature*> SERIAL(bucketMap);
-  Table<double> SERIAL(lightAmount);
+  /** Caches derived from the squares and creatures, rebuilt on first use after loading.*/
+  mutable unordered_map<Vision*, FieldOfView> TRANSIENT(fieldOfView);
+  mutable unique_ptr<BucketMap<Creature*>> TRANSIENT(bucketMap);
+  mutable unique_ptr<Table<double>> TRANSIENT(lightAmount);
+  /** Light added by a source, kept so that it can be taken away without computing the field of view.*/
+  struct LightSource {
+    double radius;
+    int count;
+    vector<pair<Vec2, double>> lit;
+  };
+  mutable unordered_map<Vec2, vector<LightSource>> TRANSIENT(lightSources);
+  /** Areas changed that some view hasn't read yet, see getChanges().*/
+  mutable ChangeJournal TRANSIENT(changes);
+  mutable FlowFieldCache TRANSIENT(flowFields);
+  mutable map<MovementType, unique_ptr<PathGraph>> TRANSIENT(pathGraphs);
   
   Level(Table<PSquare> s, Model*, vector<Location*>, const string& message, const string& name,
       Table<CoverInfo> coverInfo);
 
   void addLightSource(Vec2 pos, double radius, int numLight);
+  vector<pair<Vec2, double>> getLitSquares(Vec2 pos, double radius) const;
+  void addLight(Vec2 pos, const LightSource&, int numLight) const;
+  Table<double>& getLightAmount() const;
+  BucketMap<Creature*>& getBucketMap() const;
   FieldOfView& getFieldOfView(Vision* vision) const;
   vector<Vec2> getVisibleTilesNoDarkness(Vec2 pos, Vision* vision) const;
   bool isWithinVision(Vec2 from, Vec2 to, Vision*) const;
@@ -141,7 +141,7 @@ class RoomMaker : public LevelMaker {
           }
       } while (!good && --cnt > 0);
       if (cnt == 0) {
-        Debug() << "Placed only " << i << " rooms out of " << numRooms;
+        LOG(INFO, LEVEL_GEN) << "Placed only " << i << " rooms out of " << numRooms;
         break;
       }
       for (Vec2 v : Rectangle(k))
@@ -445,7 +445,7 @@ class River : public LevelMaker {
   private:
 
   vector<Vec2> straightLine(int x0, int y0, int x1, int y1){
-    Debug() << "Line " << x1 << " " << y0 << " " << x1 << " " << y1;
+    LOG(TRACE, LEVEL_GEN) << "Line " << x1 << " " << y0 << " " << x1 << " " << y1;
     int dx = x1 - x0;
     int dy = y1 - y0;
     vector<Vec2> ret{ Vec2(x0, y0)};
@@ -972,9 +972,14 @@ class RandomLocations : public LevelMaker {
   }
 
   virtual void make(Level::Builder* builder, Rectangle area) override {
+    // The predicates only read the builder, so the tables for all the makers are computed at the same time.
+    vector<unique_ptr<LocationPredicate::Precomputed>> tables(insideMakers.size());
+    runInParallel(0, insideMakers.size(), [&] (int i, RandomGen&) {
+        tables[i].reset(new LocationPredicate::Precomputed(predicate[i].precompute(builder, area)));
+    });
     vector<LocationPredicate::Precomputed> precomputed;
-    for (int i : All(insideMakers))
-      precomputed.push_back(predicate[i].precompute(builder, area));
+    for (auto& table : tables)
+      precomputed.push_back(std::move(*table));
     for (int i : Range(3000))
       if (tryMake(builder, precomputed, area))
         return;
@@ -1027,11 +1032,19 @@ class RandomLocations : public LevelMaker {
       makerBounds.push_back(Rectangle(px, py, px + sizes[i].first, py + sizes[i].second));
     }
     CHECK(insideMakers.size() == occupied.size());
+    // Every area is generated from its own seed, so its contents don't depend on how many random numbers
+    // were used by the others.
+    vector<int> seeds;
+    for (int i : All(insideMakers))
+      seeds.push_back(Random.get(1 << 30));
+    RandomGen parent = Random;
     for (int i : All(insideMakers)) {
+      Random.init(seeds[i]);
       builder->pushMap(makerBounds[i], maps[i]);
       insideMakers[i]->make(builder, makerBounds[i]);
       builder->popMap();
     }
+    Random = parent;
     return true;
   }
 
@@ -1093,10 +1106,10 @@ class Shrine : public LevelMaker {
           builder->putSquare(fl, newWall);
       if (locationMaker)
         locationMaker->make(builder, Rectangle(pos - Vec2(1, 1), pos + Vec2(2, 2)));
-      Debug() << "Created a shrine of " << int(deity);
+      LOG(INFO, LEVEL_GEN) << "Created a shrine of " << int(deity);
       return;
     }
-    Debug() << "Didn't find a good place for the shrine of " << int(deity);
+    LOG(INFO, LEVEL_GEN) << "Didn't find a good place for the shrine of " << int(deity);
   }
 
   private:
@@ -1260,7 +1273,7 @@ class Mountains : public LevelMaker {
         ++wCnt;
       }
     }
-    Debug() << "Terrain distribution " << gCnt << " glacier, " << mCnt << " mountain, " << hCnt << " hill, " << lCnt << " lowland, " << wCnt << " water, " << sCnt << " sand";
+    LOG(INFO, LEVEL_GEN) << "Terrain distribution " << gCnt << " glacier, " << mCnt << " mountain, " << hCnt << " hill, " << lCnt << " lowland, " << wCnt << " water, " << sCnt << " sand";
   }
 
   private:
@@ -1300,7 +1313,7 @@ class Roads : public LevelMaker {
     for (Vec2 v : area)
       if (builder->hasAttrib(v, SquareAttrib::CONNECT_ROAD)) {
         points.push_back(v);
-        Debug() << "Connecting point " << v;
+        LOG(TRACE, LEVEL_GEN) << "Connecting point " << v;
       }
     for (int ind : Range(1, points.size())) {
       Vec2 p1 = points[ind];
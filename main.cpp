@@ -48,6 +48,8 @@
 #include "square.h"
 #include "spell.h"
 #include "window_view.h"
+#include "null_view.h"
+#include "benchmark.h"
 #include "clock.h"
 
 using namespace boost::iostreams;
@@ -151,7 +153,8 @@ static unique_ptr<Model> loadGame(const string& filename, bool eraseFile) {
     CompressedInput input(filename.c_str());
     Serialization::registerTypes(input.getArchive());
     string discard;
-    input.getArchive() >> BOOST_SERIALIZATION_NVP(discard) >> BOOST_SERIALIZATION_NVP(model);
+    MEASURE(input.getArchive() >> BOOST_SERIALIZATION_NVP(discard) >> BOOST_SERIALIZATION_NVP(model),
+        "loading time");
   }
   if (eraseFile)
     CHECK(!remove(filename.c_str()));
@@ -170,10 +173,22 @@ string stripNonAscii(string s) {
 static void saveGame(unique_ptr<Model> model, const string& saveSuffix) {
   string filename = model->getShortGameIdentifier() + saveSuffix;
   filename = stripNonAscii(filename);
-  CompressedOutput out(filename.c_str());
-  Serialization::registerTypes(out.getArchive());
-  string game = model->getGameIdentifier();
-  out.getArchive() << BOOST_SERIALIZATION_NVP(game) << BOOST_SERIALIZATION_NVP(model);
+  // The game is written to a temporary file first, so a failed save never replaces a previous good one.
+  string tmpFilename = filename + ".tmp";
+  try {
+    CompressedOutput out(tmpFilename.c_str());
+    Serialization::registerTypes(out.getArchive());
+    string game = model->getGameIdentifier();
+    MEASURE(out.getArchive() << BOOST_SERIALIZATION_NVP(game) << BOOST_SERIALIZATION_NVP(model), "saving time");
+  } catch (...) {
+    remove(tmpFilename.c_str());
+    throw;
+  }
+#ifdef WINDOWS // rename doesn't replace existing files
+  remove(filename.c_str());
+#endif
+  if (rename(tmpFilename.c_str(), filename.c_str()))
+    throw string("Couldn't rename " + tmpFilename + " to " + filename);
 }
 
 static void saveExceptionLine(const string& path, const string& line) {
@@ -181,6 +196,22 @@ static void saveExceptionLine(const string& path, const string& line) {
   of << line << std::endl;
 }
 
+/** World generation sometimes fails, and then it's started again from scratch. Returns null and the last error
+    if all attempts failed.*/
+static PModel generateKeeperWorld(ProgressMeter& meter, Options* options, View* view,
+    function<string()> worldName, string& error) {
+  for (int i : Range(5)) {
+    meter.reset();
+    try {
+      return PModel(Model::collectiveModel(meter, options, view, worldName()));
+    } catch (string s) {
+      LOG(INFO, GENERAL) << "World generation failed: " << s;
+      error = s;
+    }
+  }
+  return nullptr;
+}
+
 void clearSingletons() {
   Quest::clearAll();
   Tribe::clearAll();
@@ -257,15 +288,69 @@ void initializeJukebox(Jukebox& jukebox) {
 class MainLoop {
   public:
   MainLoop(View* v, Options* o, Jukebox* j, std::atomic<bool>& fin)
-      : view(v), options(o), jukebox(j), finished(fin) {}
+      : view(v), options(o), jukebox(j), finished(fin), saveDone(false) {}
 
+  /** The game can be left while it's still being saved, by closing the window or by an exception, and a
+      thread that isn't joined terminates the program.*/
+  ~MainLoop() {
+    if (saveThread)
+      saveThread->join();
+    Square::progressMeter = nullptr;
+  }
+
+  /** The model isn't used after the game ends, so it's written by a separate thread while the player is
+      back in the menu. The singletons it refers to are cleared only once it's done, see waitForSave().*/
   void saveUI(PModel model, Model::GameType type) {
-    ProgressMeter meter(1.0 / 62500);
-    Square::progressMeter = &meter;
-    view->displaySplash(meter, View::SAVING);
-    saveGame(std::move(model), getSaveSuffix(type));
+    CHECK(!saveThread);
+    saveMeter.reset(new ProgressMeter(1.0 / 62500));
+    Square::progressMeter = saveMeter.get();
+    saveDone = false;
+    string suffix = getSaveSuffix(type);
+    auto save = [this, suffix] (Model* m) {
+      try {
+        saveGame(PModel(m), suffix);
+      } catch (string s) {
+        saveExceptionLine("crash.log", "Saving failed: " + s);
+        saveError = std::current_exception();
+      } catch (std::exception& e) {
+        saveExceptionLine("crash.log", string("Saving failed: ") + e.what());
+        saveError = std::current_exception();
+      } catch (...) {
+        saveExceptionLine("crash.log", "Saving failed");
+        saveError = std::current_exception();
+      }
+      saveDone = true;
+    };
+#ifdef OSX // see thread comment in stdafx.h
+    saveThread.reset(new thread(getAttributes(), std::bind(save, model.release())));
+#else
+    saveThread.reset(new thread(save, model.release()));
+#endif
+  }
+
+  /** Blocks until the game being saved is written, showing the saving screen if necessary. If saving
+      failed, the error is rethrown here, on the main thread.*/
+  void waitForSave() {
+    if (!saveThread)
+      return;
+    if (!saveDone)
+      view->displaySplash(*saveMeter, View::SAVING);
+    saveThread->join();
     view->clearSplash();
+    saveThread.reset();
     Square::progressMeter = nullptr;
+    saveMeter.reset();
+    clearSingletons();
+    if (saveError) {
+      std::exception_ptr error = saveError;
+      saveError = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  void finishGame() {
+    if (!saveThread)
+      clearSingletons();
   }
 
   void playModel(PModel model) {
@@ -301,6 +386,7 @@ class MainLoop {
           0, View::MAIN_MENU);
       if (!choice)
         return;
+      waitForSave();
       initializeSingletons();
       PModel model;
       switch (*choice) {
@@ -328,7 +414,7 @@ class MainLoop {
         model->setOptions(options);
         playModel(std::move(model));
       }
-      clearSingletons();
+      finishGame();
       view->reset();
     }
   }
@@ -356,7 +442,7 @@ class MainLoop {
         case 1: options->handle(view, OptionSet::GENERAL); break;
         case 2: Model::showHighscore(view); break;
         case 3: Model::showCredits(view); break;
-        case 4: finished = true; break;
+        case 4: waitForSave(); finished = true; break;
       }
       if (finished)
         break;
@@ -368,15 +454,8 @@ class MainLoop {
     string ex;
     ProgressMeter meter(1.0 / 166000);
     view->displaySplash(meter, View::CREATING);
-    for (int i : Range(5)) {
-      try {
-        model.reset(Model::collectiveModel(meter, options, view,
-              NameGenerator::get(NameGeneratorId::WORLD)->getNext()));
-        break;
-      } catch (string s) {
-        ex = s;
-      }
-    }
+    model = generateKeeperWorld(meter, options, view,
+        [] { return NameGenerator::get(NameGeneratorId::WORLD)->getNext(); }, ex);
     if (!model) {
       view->presentText("Sorry!", "World generation permanently failed with the following error:\n \n" + ex +
           "\n \nIf you would be so kind, please send the file \'crash.log\'"
@@ -390,6 +469,7 @@ class MainLoop {
   PModel loadModel(string file, bool erase) {
     ProgressMeter meter(1.0 / 62500);
     Square::progressMeter = &meter;
+    OnExit clearMeter([] { Square::progressMeter = nullptr; });
     view->displaySplash(meter, View::LOADING);
     PModel ret = loadGame(file, erase);
     ret->setView(view);
@@ -430,6 +510,10 @@ class MainLoop {
   Options* options;
   Jukebox* jukebox;
   std::atomic<bool>& finished;
+  unique_ptr<thread> saveThread;
+  unique_ptr<ProgressMeter> saveMeter;
+  atomic<bool> saveDone;
+  std::exception_ptr saveError;
 };
 
 int main(int argc, char* argv[]) {
@@ -438,17 +522,44 @@ int main(int argc, char* argv[]) {
     ("help", "Print help")
     ("run_tests", "Run all unit tests and exit")
     ("gen_world_exit", "Exit after creating a world")
+    ("bench", value<string>(), "Run a headless benchmark scenario and exit: "
+        "early_keeper, minions100, village_siege or adventurer")
+    ("bench_turns", value<int>(), "Number of turns to simulate in the benchmark")
+    ("bench_save", value<string>(), "Run the benchmark on a saved game instead of a new world")
     ("force_keeper", "Skip main menu and force keeper mode")
     ("seed", value<int>(), "Use given seed")
-    ("replay", value<string>(), "Replay game from file");
+    ("replay", value<string>(), "Replay game from file")
+    ("profile", value<string>(), "Write a Chrome trace of the session to file")
+    ("log_level", value<string>(), "Log messages of this level and above: trace, info or warning")
+    ("log_categories", value<string>(), "Log only these comma separated categories, eg. model,path")
+    ("print_log", value<string>(), "Pretty print a log file and exit");
   variables_map vars;
   store(parse_command_line(argc, argv, flags), vars);
   if (vars.count("help")) {
     std::cout << flags << endl;
     return 0;
   }
+  if (vars.count("print_log")) {
+    Log::print(vars["print_log"].as<string>(), std::cout);
+    return 0;
+  }
+  if (vars.count("log_level") && !Log::setLevel(vars["log_level"].as<string>())) {
+    std::cout << "Unknown log level " << vars["log_level"].as<string>() << endl;
+    return -1;
+  }
+  if (vars.count("log_categories") && !Log::setCategories(vars["log_categories"].as<string>())) {
+    std::cout << "Unknown log category in " << vars["log_categories"].as<string>() << endl;
+    return -1;
+  }
+  if (vars.count("profile"))
+    Profiler::enable();
+  auto dumpProfile = [&] {
+    if (vars.count("profile"))
+      Profiler::dump(vars["profile"].as<string>());
+  };
   if (vars.count("run_tests")) {
     testAll();
+    dumpProfile();
     return 0;
   }
   unique_ptr<View> view;
@@ -457,16 +568,63 @@ int main(int argc, char* argv[]) {
   string lognamePref = "log";
   Debug::init();
   Options options("options.txt");
+  if (vars.count("gen_world_exit")) {
+    Random.init(vars.count("seed") ? vars["seed"].as<int>() : int(time(0)));
+    initializeSingletons();
+    ProgressMeter meter(1.0 / 166000);
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point begin = Clock::now();
+    string error;
+    PModel model = generateKeeperWorld(meter, &options, nullptr, [] { return "Benchmark"; }, error);
+    double millis = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    if (!model) {
+      std::cout << "World generation failed: " << error << endl;
+      return -1;
+    }
+    // The meter's scale is tuned to reach 1 at the end of generation, the splash screen shows it.
+    std::cout << "World generated in " << int(millis) << " ms, progress meter at " << meter.getProgress() << endl;
+    dumpProfile();
+    return 0;
+  }
+  if (vars.count("bench")) {
+    auto scenario = Benchmark::getScenario(vars["bench"].as<string>());
+    if (!scenario) {
+      std::cout << "Unknown benchmark scenario " << vars["bench"].as<string>() << endl;
+      return -1;
+    }
+    int seed = vars.count("seed") ? vars["seed"].as<int>() : int(time(0));
+    Random.init(seed);
+    initializeSingletons();
+    NullView nullView;
+    PModel model;
+    if (vars.count("bench_save")) {
+      model = loadGame(vars["bench_save"].as<string>(), false);
+      model->setView(&nullView);
+    } else {
+      ProgressMeter meter(1.0 / 166000);
+      string error;
+      model = generateKeeperWorld(meter, &options, &nullView, [] { return "Benchmark"; }, error);
+      if (!model) {
+        std::cout << "World generation failed: " << error << endl;
+        return -1;
+      }
+    }
+    model->setOptions(&options);
+    Benchmark::setup(model.get(), *scenario);
+    std::cout << "Benchmark " << vars["bench"].as<string>() << ", seed " << seed << endl;
+    Benchmark::run(model.get(), vars.count("bench_turns") ? vars["bench_turns"].as<int>() : 1000, std::cout);
+    dumpProfile();
+    return 0;
+  }
   Renderer renderer("KeeperRL", Vec2(36, 36));
   Clock clock;
   if (tilesPresent())
     initializeRendererTiles(renderer);
   int seed = vars.count("seed") ? vars["seed"].as<int>() : int(time(0));
  // int forceMode = vars.count("force_keeper") ? 0 : -1;
-  bool genExit = vars.count("gen_world_exit");
   if (vars.count("replay")) {
     string fname = vars["replay"].as<string>();
-    Debug() << "Reading from " << fname;
+    LOG(INFO, GENERAL) << "Reading from " << fname;
     seed = fromString<int>(fname.substr(lognamePref.size()));
     Random.init(seed);
     input.reset(new CompressedInput(fname));
@@ -476,7 +634,7 @@ int main(int argc, char* argv[]) {
     string fname(lognamePref);
     fname += toString(seed);
     output.reset(new CompressedOutput(fname));
-    Debug() << "Writing to " << fname;
+    LOG(INFO, GENERAL) << "Writing to " << fname;
     view.reset(WindowView::createLoggingView(output->getArchive(), {renderer, tilesPresent(), &options, &clock}));
   } 
   std::atomic<bool> gameFinished(false);
@@ -496,6 +654,7 @@ int main(int argc, char* argv[]) {
   game();
 #endif
   t.join();
+  dumpProfile();
   return 0;
 }
 
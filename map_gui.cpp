@@ -26,10 +26,12 @@
 #include "view_id.h"
 #include "level.h"
 #include "creature_view.h"
+#include "creature.h"
 
 using sf::Keyboard;
 
-MapGui::MapGui(Callbacks call, Clock* c) : objects(Level::getMaxBounds()), callbacks(call), clock(c),
+MapGui::MapGui(Callbacks call, Clock* c) : objectIndex(Level::getMaxBounds(), -1),
+    tileUpdate(Level::getMaxBounds(), -1), callbacks(call), clock(c),
     fogOfWar(Level::getMaxBounds(), false), extraBorderPos(Level::getMaxBounds(), {}) {
   clearCenter();
 }
@@ -99,6 +101,10 @@ class ViewIdMap {
     ids.clear();
   }
 
+  void clear(Vec2 pos) {
+    ids.erase(pos);
+  }
+
   private:
   unordered_map<Vec2, unordered_set<ViewId>> ids;
 };
@@ -403,25 +409,161 @@ void MapGui::drawObjectAbs(Renderer& renderer, int x, int y, const ViewObject& o
   }
 }
 
-void MapGui::updateObjects(const CreatureView* view, MapLayout* mapLayout, bool smoothMovement) {
+const ViewIndex* MapGui::getObjects(Vec2 wpos) const {
+  if (!wpos.inRectangle(objectIndex.getBounds()))
+    return nullptr;
+  int index = objectIndex[wpos];
+  return index > -1 ? &objects[index] : nullptr;
+}
+
+void MapGui::Update::clear() {
+  dropObjects = false;
+  tiles.clear();
+  numIndexes = 0;
+}
+
+ViewIndex& MapGui::Update::addTile(Vec2 pos) {
+  if (numIndexes == indexes.size())
+    indexes.emplace_back();
+  else
+    indexes[numIndexes].clear();
+  tiles.emplace_back(pos, numIndexes);
+  return indexes[numIndexes++];
+}
+
+void MapGui::refreshObjects(const CreatureView* view, Vec2 wpos, Update& update) {
+  if (tileUpdate[wpos] == updateNum)
+    return;
+  tileUpdate[wpos] = updateNum;
+  ViewIndex& objs = update.addTile(wpos);
+  view->getViewIndex(wpos, objs);
+  if (!objs.isEmpty())
+    objs.setHighlight(HighlightType::NIGHT, 1.0 - view->getLevel()->getLight(wpos));
+}
+
+void MapGui::storeObjects(Vec2 wpos, const ViewIndex& index) {
+  int& slot = objectIndex[wpos];
+  if (slot == -1) {
+    if (freeObjects.empty()) {
+      objects.emplace_back();
+      objectsPos.push_back(wpos);
+      slot = objects.size() - 1;
+    } else {
+      slot = freeObjects.back();
+      freeObjects.pop_back();
+    }
+  }
+  objectsPos[slot] = wpos;
+  ViewIndex& objs = objects[slot];
+  objs = index;
+  connectionMap.clear(wpos);
+  if (objs.hasObject(ViewLayer::FLOOR))
+    if (auto id = getConnectionId(objs.getObject(ViewLayer::FLOOR)))
+      connectionMap.add(wpos, *id);
+  if (objs.hasObject(ViewLayer::FLOOR_BACKGROUND))
+    if (auto id = getConnectionId(objs.getObject(ViewLayer::FLOOR_BACKGROUND)))
+      connectionMap.add(wpos, *id);
+  if (auto viewId = objs.getHiddenId())
+    if (auto id = getConnectionId(*viewId))
+      connectionMap.add(wpos, *id);
+  refreshedTiles.push_back(wpos);
+}
+
+void MapGui::releaseObjects(Vec2 wpos) {
+  if (objectIndex[wpos] == -1)
+    return;
+  freeObjects.push_back(objectIndex[wpos]);
+  objectIndex[wpos] = -1;
+  connectionMap.clear(wpos);
+  refreshedTiles.push_back(wpos);
+}
+
+void MapGui::dropObjects() {
+  freeObjects.clear();
+  for (int i : All(objects)) {
+    objectIndex[objectsPos[i]] = -1;
+    freeObjects.push_back(i);
+  }
+  connectionMap.clear();
+  shadowed.clear();
+}
+
+bool MapGui::castsShadow(Vec2 wpos) const {
+  const ViewIndex* index = getObjects(wpos);
+  return index && index->hasObject(ViewLayer::FLOOR)
+      && index->getObject(ViewLayer::FLOOR).hasModifier(ViewObject::Modifier::CASTS_SHADOW);
+}
+
+void MapGui::updateShadow(Vec2 wpos) {
+  if (castsShadow(wpos - Vec2(0, 1)) && !castsShadow(wpos))
+    shadowed.insert(wpos);
+  else
+    shadowed.erase(wpos);
+}
+
+void MapGui::clearObjects() {
+  indexedTiles = Nothing();
+  lastView = nullptr;
+  lastLevel = nullptr;
+}
+
+void MapGui::updateObjects(const CreatureView* view, Rectangle tiles, bool smoothMovement, Update& update) {
   const Level* level = view->getLevel();
-  for (Vec2 pos : mapLayout->getAllTiles(getBounds(), Level::getMaxBounds()))
-    objects[pos] = Nothing();
+  Optional<vector<Rectangle>> changes = level->getChanges(this);
+  if (!changes || view != lastView || level != lastLevel) {
+    clearObjects();
+    // Tiles still waiting for the render thread would be dropped anyway.
+    update.clear();
+    update.dropObjects = true;
+    lastView = view;
+    lastLevel = level;
+  }
+  ++updateNum;
+  int numTiles = update.numIndexes;
+  if (indexedTiles)
+    for (Vec2 pos : *indexedTiles)
+      if (!pos.inRectangle(tiles) && level->inBounds(pos))
+        update.tiles.emplace_back(pos, -1);
+  for (Vec2 pos : tiles)
+    if ((!indexedTiles || !pos.inRectangle(*indexedTiles)) && level->inBounds(pos))
+      refreshObjects(view, pos, update);
+  if (changes)
+    for (Rectangle area : *changes)
+      if (area.intersects(tiles))
+        for (Vec2 pos : area.intersection(tiles))
+          if (level->inBounds(pos))
+            refreshObjects(view, pos, update);
+  level->forEachCreature(tiles, [&] (Creature* c) { refreshObjects(view, c->getPosition(), update); });
+  indexedTiles = tiles;
+  LOG(TRACE, GUI) << "Map update refreshed " << update.numIndexes - numTiles << " of " << (tiles.getW() * tiles.getH())
+      << " tiles";
+  update.levelBounds = level->getBounds();
+  update.position = view->getPosition(false);
+  update.defaultPosition = *view->getPosition(true);
+  update.movement = view->getMovementInfo();
+  update.currentTimeGame = smoothMovement ? view->getTime() : 1000000000;
+}
+
+void MapGui::applyUpdate(const Update& update, MapLayout* mapLayout) {
+  if (update.dropObjects)
+    dropObjects();
   if (!isCentered())
-    setCenter(*view->getPosition(true));
-  else if (auto pos = view->getPosition(false))
-    setCenter(*pos);
-  updateLayout(mapLayout, view->getLevel()->getBounds());
-  for (Vec2 pos : mapLayout->getAllTiles(getBounds(), Level::getMaxBounds())) 
-    if (level->inBounds(pos)) {
-      ViewIndex index;
-      view->getViewIndex(pos, index);
-      if (!index.isEmpty())
-        index.setHighlight(HighlightType::NIGHT, 1.0 - view->getLevel()->getLight(pos));
-      objects[pos] = index;
-    }
-  currentTimeGame = smoothMovement ? view->getTime() : 1000000000;
-  if (auto movement = view->getMovementInfo()) {
+    setCenter(update.defaultPosition);
+  else if (update.position)
+    setCenter(*update.position);
+  updateLayout(mapLayout, update.levelBounds);
+  refreshedTiles.clear();
+  for (auto& tile : update.tiles)
+    if (tile.second == -1)
+      releaseObjects(tile.first);
+    else
+      storeObjects(tile.first, update.indexes[tile.second]);
+  for (Vec2 pos : refreshedTiles) {
+    updateShadow(pos);
+    updateShadow(pos + Vec2(0, 1));
+  }
+  currentTimeGame = update.currentTimeGame;
+  if (auto& movement = update.movement) {
     if (!screenMovement || screenMovement->startTimeGame != movement->prevTime) {
       screenMovement = {
         movement->from,
@@ -435,27 +577,11 @@ void MapGui::updateObjects(const CreatureView* view, MapLayout* mapLayout, bool
     }
   } else
     screenMovement = Nothing();
-  connectionMap.clear();
-  shadowed.clear();
-  for (Vec2 wpos : layout->getAllTiles(getBounds(), objects.getBounds()))
-    if (auto& index = objects[wpos]) {
-      if (index->hasObject(ViewLayer::FLOOR)) {
-        const ViewObject& object = index->getObject(ViewLayer::FLOOR);
-        if (object.hasModifier(ViewObject::Modifier::CASTS_SHADOW)) {
-          shadowed.erase(wpos);
-          shadowed.insert(wpos + Vec2(0, 1));
-        }
-        if (auto id = getConnectionId(object))
-          connectionMap.add(wpos, *id);
-      }
-      if (index->hasObject(ViewLayer::FLOOR_BACKGROUND)) {
-        if (auto id = getConnectionId(index->getObject(ViewLayer::FLOOR_BACKGROUND)))
-          connectionMap.add(wpos, *id);
-      }
-      if (auto viewId = index->getHiddenId())
-        if (auto id = getConnectionId(*viewId))
-          connectionMap.add(wpos, *id);
-    }
+}
+
+Rectangle MapGui::getVisibleTiles(MapLayout* mapLayout, Rectangle bounds) {
+  updateLayout(mapLayout, levelBounds);
+  return mapLayout->getAllTiles(bounds);
 }
 
 void MapGui::clearCenter() {
@@ -506,8 +632,8 @@ bool MapGui::isFoW(Vec2 pos) const {
 
 void MapGui::renderExtraBorders(Renderer& renderer, int currentTimeReal) {
   for (Vec2 wpos : layout->getAllTiles(getBounds(), levelBounds))
-    if (objects[wpos] && objects[wpos]->hasObject(ViewLayer::FLOOR_BACKGROUND)) {
-      ViewId viewId = objects[wpos]->getObject(ViewLayer::FLOOR_BACKGROUND).id();
+    if (getObjects(wpos) && getObjects(wpos)->hasObject(ViewLayer::FLOOR_BACKGROUND)) {
+      ViewId viewId = getObjects(wpos)->getObject(ViewLayer::FLOOR_BACKGROUND).id();
       if (Tile::fromViewId(viewId).hasExtraBorders())
         for (Vec2 v : wpos.neighbors4())
           if (v.inRectangle(extraBorderPos.getBounds())) {
@@ -549,6 +675,7 @@ Vec2 MapGui::projectOnScreen(Vec2 wpos, int curTime) {
 }
 
 void MapGui::render(Renderer& renderer) {
+  PROFILE_ZONE("map render");
   int sizeX = layout->squareWidth();
   int sizeY = layout->squareHeight();
   int currentTimeReal = clock->getRealMillis();
@@ -556,13 +683,13 @@ void MapGui::render(Renderer& renderer) {
   renderer.drawFilledRectangle(Rectangle(
         projectOnScreen(levelBounds.getTopLeft(), currentTimeReal),
         projectOnScreen(levelBounds.getBottomRight(), currentTimeReal)), colors[ColorId::BLACK]);
-  Optional<ViewObject> highlighted;
+  const ViewObject* highlighted = nullptr;
   fogOfWar.clear();
   extraBorderPos.clear();
   for (ViewLayer layer : layout->getLayers()) {
     for (Vec2 wpos : layout->getAllTiles(getBounds(), levelBounds)) {
       Vec2 pos = projectOnScreen(wpos, currentTimeReal);
-      if (!objects[wpos] || objects[wpos]->noObjects()) {
+      if (!getObjects(wpos) || getObjects(wpos)->noObjects()) {
         if (layer == layout->getLayers().back()) {
           if (wpos.inRectangle(levelBounds))
             renderer.drawFilledRectangle(pos.x, pos.y, pos.x + sizeX, pos.y + sizeY, colors[ColorId::BLACK]);
@@ -570,7 +697,7 @@ void MapGui::render(Renderer& renderer) {
         fogOfWar.setValue(wpos, true);
         continue;
       }
-      const ViewIndex& index = *objects[wpos];
+      const ViewIndex& index = *getObjects(wpos);
       const ViewObject* object = nullptr;
       if (spriteMode) {
         if (index.hasObject(layer))
@@ -580,7 +707,7 @@ void MapGui::render(Renderer& renderer) {
       if (object) {
         drawObjectAbs(renderer, pos.x, pos.y, *object, sizeX, sizeY, wpos, currentTimeReal);
         if (highlightedPos == wpos)
-          highlighted = *object;
+          highlighted = object;
       }
       if (contains({ViewLayer::FLOOR, ViewLayer::FLOOR_BACKGROUND}, layer) && highlightedPos == wpos) {
         renderer.drawFilledRectangle(pos.x, pos.y, pos.x + sizeX, pos.y + sizeY, Color::Transparent,
@@ -604,7 +731,7 @@ void MapGui::render(Renderer& renderer) {
       renderExtraBorders(renderer, currentTimeReal);
   }
   for (Vec2 wpos : layout->getAllTiles(getBounds(), levelBounds))
-    if (auto index = objects[wpos]) {
+    if (const ViewIndex* index = getObjects(wpos)) {
       Vec2 pos = projectOnScreen(wpos, currentTimeReal);
       for (HighlightType highlight : ENUM_ALL(HighlightType))
         if (index->getHighlight(highlight) > 0)
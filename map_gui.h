@@ -20,13 +20,13 @@
 #include "gui_elem.h"
 #include "view_id.h"
 #include "unique_entity.h"
+#include "view_index.h"
+#include "creature_view.h"
 
-class ViewIndex;
 class MapMemory;
 class MapLayout;
 class ViewObject;
 class Renderer;
-class CreatureView;
 class Clock;
 
 class MapGui : public GuiElem {
@@ -38,6 +38,27 @@ class MapGui : public GuiElem {
   };
   MapGui(Callbacks, Clock*);
 
+  /** Changes to the map collected on the game thread and applied on the render thread. If the render
+      thread hasn't picked up an update yet, the next one is appended to it, so no tile is lost.*/
+  struct Update {
+    /** The render thread drops all its view indexes before applying the tiles.*/
+    bool dropObjects = false;
+    /** Tiles in the order they were refreshed, with their index in \paramname{indexes},
+        or -1 if the tile went off the screen.*/
+    vector<pair<Vec2, int>> tiles;
+    vector<ViewIndex> indexes;
+    int numIndexes = 0;
+    Rectangle levelBounds = Rectangle(1, 1);
+    Optional<Vec2> position;
+    Vec2 defaultPosition;
+    Optional<CreatureView::MovementInfo> movement;
+    double currentTimeGame = 0;
+
+    /** Starts a new update, keeping the allocated view indexes for reuse.*/
+    void clear();
+    ViewIndex& addTile(Vec2);
+  };
+
   virtual void render(Renderer&) override;
   virtual bool onLeftClick(Vec2) override;
   virtual bool onRightClick(Vec2) override;
@@ -45,7 +66,13 @@ class MapGui : public GuiElem {
   virtual void onMouseRelease() override;
   virtual void onKeyPressed2(Event::KeyEvent) override;
 
-  void updateObjects(const CreatureView*, MapLayout*, bool smoothMovement);
+  /** Called on the game thread. Refreshes the tiles that changed since the last update, or came into
+      \paramname{tiles}, into the update.*/
+  void updateObjects(const CreatureView*, Rectangle tiles, bool smoothMovement, Update&);
+  /** Called on the render thread.*/
+  void applyUpdate(const Update&, MapLayout*);
+  /** Tiles shown around the current center, including the ones just off the screen.*/
+  Rectangle getVisibleTiles(MapLayout*, Rectangle bounds);
   void updateLayout(MapLayout*, Rectangle levelBounds);
   void setSpriteMode(bool);
   Optional<Vec2> getHighlightedTile(Renderer& renderer);
@@ -55,6 +82,8 @@ class MapGui : public GuiElem {
   void setCenter(Vec2 pos);
   void clearCenter();
   bool isCentered() const;
+  /** Forgets the tiles sent to the render thread, so that the next update refreshes all of them.*/
+  void clearObjects();
 
   private:
   void drawObjectAbs(Renderer&, int x, int y, const ViewObject&, int sizeX, int sizeY, Vec2 tilePos,
@@ -66,8 +95,28 @@ class MapGui : public GuiElem {
   void renderExtraBorders(Renderer&, int currentTimeReal);
   Vec2 getMovementOffset(const ViewObject&, Vec2 size, double time, int curTimeReal);
   Vec2 projectOnScreen(Vec2 wpos, int currentTimeReal);
+  const ViewIndex* getObjects(Vec2 wpos) const;
+  void refreshObjects(const CreatureView*, Vec2 wpos, Update&);
+  void storeObjects(Vec2 wpos, const ViewIndex&);
+  void releaseObjects(Vec2 wpos);
+  void dropObjects();
+  bool castsShadow(Vec2 wpos) const;
+  void updateShadow(Vec2 wpos);
   MapLayout* layout;
-  Table<Optional<ViewIndex>> objects;
+  /** View indexes of the tiles on screen, owned by the render thread. They are kept between updates and
+      refilled in place.*/
+  vector<ViewIndex> objects;
+  vector<Vec2> objectsPos;
+  vector<int> freeObjects;
+  Table<int> objectIndex;
+  vector<Vec2> refreshedTiles;
+  /** Owned by the game thread. Only the tiles marked in the level's change journal, the ones holding
+      creatures and the ones that scrolled into view are refreshed.*/
+  Optional<Rectangle> indexedTiles;
+  Table<int> tileUpdate;
+  const CreatureView* lastView = nullptr;
+  const Level* lastLevel = nullptr;
+  int updateNum = 0;
   bool spriteMode;
   Rectangle levelBounds = Rectangle(1, 1);
   Callbacks callbacks;
@@ -47,11 +47,14 @@ Vec2 MapLayout::getPlayerPos() {
   return center.div(Vec2(squareW, squareH));
 }
 
-Rectangle MapLayout::getAllTiles(Rectangle screenBounds1, Rectangle tableBounds) {
-  vector<Vec2> ret;
+Rectangle MapLayout::getAllTiles(Rectangle screenBounds, Rectangle tableBounds) {
+  return tableBounds.intersection(getAllTiles(screenBounds));
+}
+
+Rectangle MapLayout::getAllTiles(Rectangle screenBounds1) {
   Rectangle screenBounds = screenBounds1.minusMargin(-2 * squareH);
   Rectangle grid(screenBounds.getW() / squareW, screenBounds.getH() / squareH);
   Vec2 offset = center.div(Vec2(squareW, squareH)) - grid.middle();
-  return tableBounds.intersection(grid.translate(offset));
+  return grid.translate(offset);
 }
 
@@ -33,6 +33,7 @@ class MapLayout {
   Vec2 projectOnScreen(Rectangle bounds, double x, double y);
   Vec2 projectOnMap(Rectangle bounds, Vec2 screenPos);
   Rectangle getAllTiles(Rectangle screenBounds, Rectangle tableBounds);
+  Rectangle getAllTiles(Rectangle screenBounds);
   void updatePlayerPos(Vec2);
   Vec2 getPlayerPos();
 
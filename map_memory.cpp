@@ -16,48 +16,124 @@
 #include "stdafx.h"
 
 #include "map_memory.h"
-#include "level.h"
-#include "view_object.h"
-
-MapMemory::MapMemory() : table(Level::getMaxBounds()) {
-}
-
-MapMemory::MapMemory(const MapMemory& other) : table(other.table.getWidth(), other.table.getHeight()) {
-  for (Vec2 v : table.getBounds())
-    table[v] = other.table[v];
-}
 
 template <class Archive> 
 void MapMemory::serialize(Archive& ar, const unsigned int version) {
-  ar & SVAR(table);
+  ar& SVAR(chunks)
+    & SVAR(objects);
   CHECK_SERIAL;
+  if (Archive::is_loading::value)
+    for (int i : All(objects))
+      objectIndex[objects[i]] = i;
 }
 
 SERIALIZABLE(MapMemory);
 
+template <class Archive> 
+void MapMemory::RememberedSquare::serialize(Archive& ar, const unsigned int version) {
+  ar& BOOST_SERIALIZATION_NVP(objects)
+    & BOOST_SERIALIZATION_NVP(highlight)
+    & BOOST_SERIALIZATION_NVP(remembered);
+}
+
+SERIALIZABLE(MapMemory::RememberedSquare);
+
+MapMemory::RememberedSquare::RememberedSquare() : remembered(false) {
+  for (int& index : objects)
+    index = -1;
+  for (unsigned char& amount : highlight)
+    amount = 0;
+}
+
+MapMemory::RememberedSquare& MapMemory::modSquare(Vec2 pos) {
+  Chunk& chunk = chunks[Vec2(pos.x / chunkSize, pos.y / chunkSize)];
+  if (chunk.empty())
+    chunk.resize(chunkSize * chunkSize);
+  return chunk[(pos.y % chunkSize) * chunkSize + pos.x % chunkSize];
+}
+
+const MapMemory::RememberedSquare* MapMemory::getSquare(Vec2 pos) const {
+  auto chunk = chunks.find(Vec2(pos.x / chunkSize, pos.y / chunkSize));
+  if (chunk == chunks.end())
+    return nullptr;
+  const RememberedSquare& square = chunk->second[(pos.y % chunkSize) * chunkSize + pos.x % chunkSize];
+  return square.remembered ? &square : nullptr;
+}
+
+int MapMemory::addViewObject(const ViewObject& obj) {
+  auto elem = objectIndex.find(obj);
+  if (elem != objectIndex.end())
+    return elem->second;
+  objects.push_back(obj);
+  objectIndex[obj] = objects.size() - 1;
+  return objects.size() - 1;
+}
+
 void MapMemory::addObject(Vec2 pos, const ViewObject& obj) {
-  if (!table[pos])
-    table[pos] = ViewIndex();
-  table[pos]->insert(obj);
-  table[pos]->setHighlight(HighlightType::MEMORY);
+  RememberedSquare& square = modSquare(pos);
+  square.objects[int(obj.layer())] = addViewObject(obj);
+  square.highlight[int(HighlightType::MEMORY)] = 255;
+  square.remembered = true;
 }
 
 void MapMemory::update(Vec2 pos, const ViewIndex& index) {
-  table[pos] = index;
-  table[pos]->setHighlight(HighlightType::MEMORY);
-  table[pos]->removeObject(ViewLayer::CREATURE);
+  RememberedSquare& square = modSquare(pos) = RememberedSquare();
+  for (ViewLayer layer : ENUM_ALL(ViewLayer))
+    if (layer != ViewLayer::CREATURE && index.hasObject(layer))
+      square.objects[int(layer)] = addViewObject(index.getObject(layer));
+  for (HighlightType highlight : ENUM_ALL(HighlightType))
+    square.highlight[int(highlight)] = round(max(0.0, min(1.0, index.getHighlight(highlight))) * 255);
+  square.highlight[int(HighlightType::MEMORY)] = 255;
+  square.remembered = true;
 }
 
 void MapMemory::clearSquare(Vec2 pos) {
-  table[pos] = Nothing();
+  auto chunk = chunks.find(Vec2(pos.x / chunkSize, pos.y / chunkSize));
+  if (chunk == chunks.end())
+    return;
+  chunk->second[(pos.y % chunkSize) * chunkSize + pos.x % chunkSize] = RememberedSquare();
+  for (const RememberedSquare& square : chunk->second)
+    if (square.remembered)
+      return;
+  chunks.erase(chunk);
 }
 
 bool MapMemory::hasViewIndex(Vec2 pos) const {
-  return table[pos];
+  return getSquare(pos);
+}
+
+void MapMemory::insertObject(Vec2 pos, const RememberedSquare& square, ViewLayer layer, ViewIndex& index) const {
+  int objIndex = square.objects[int(layer)];
+  if (objIndex > -1) {
+    index.insert(objects[objIndex]);
+    index.getObject(layer).setPosition(pos);
+  }
+}
+
+void MapMemory::mergeInto(Vec2 pos, ViewIndex& index) const {
+  const RememberedSquare* square = getSquare(pos);
+  CHECK(square) << "Square not remembered " << pos;
+  if (index.isEmpty()) {
+    index.clear(); // the remembered square replaces the hidden id
+    for (ViewLayer layer : ENUM_ALL(ViewLayer))
+      insertObject(pos, *square, layer, index);
+    for (HighlightType highlight : ENUM_ALL(HighlightType))
+      if (square->highlight[int(highlight)] > 0)
+        index.setHighlight(highlight, square->highlight[int(highlight)] / 255.0);
+  } else if (!index.hasObject(ViewLayer::FLOOR) && !index.hasObject(ViewLayer::FLOOR_BACKGROUND)) {
+    // special case when monster or item is visible but floor is only in memory
+    insertObject(pos, *square, ViewLayer::FLOOR, index);
+    insertObject(pos, *square, ViewLayer::FLOOR_BACKGROUND, index);
+  }
 }
 
-ViewIndex MapMemory::getViewIndex(Vec2 pos) const {
-  return *table[pos];
+size_t MapMemory::getMemoryUsage() const {
+  size_t ret = sizeof(MapMemory);
+  for (auto& chunk : chunks)
+    ret += sizeof(chunk) + sizeof(void*) + chunk.second.capacity() * sizeof(RememberedSquare);
+  ret += objects.capacity() * sizeof(ViewObject);
+  ret += objectIndex.size() * (sizeof(pair<ViewObject, int>) + sizeof(void*));
+  return ret;
 }
   
 const MapMemory& MapMemory::empty() {
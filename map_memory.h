@@ -17,19 +17,23 @@
 #define _MEMORY_H
 
 #include "view_index.h"
+#include "view_object.h"
 #include "util.h"
 
-class ViewObject;
-
+/** Squares remembered by a player. Squares are stored in chunks that are allocated when a square in them
+    is first seen, so the memory and the save file grow with the explored area rather than the maximum
+    level size. Each distinct ViewObject is stored once and squares keep indexes to them.*/
 class MapMemory {
   public:
-  MapMemory();
-  MapMemory(const MapMemory&);
   void addObject(Vec2 pos, const ViewObject& obj);
   void update(Vec2, const ViewIndex&);
   void clearSquare(Vec2 pos);
   bool hasViewIndex(Vec2 pos) const;
-  ViewIndex getViewIndex(Vec2 pos) const;
+  /** Merges the remembered square, which must be remembered, into the index. If the index is empty
+      it gets the whole square, otherwise only a missing floor is filled in.*/
+  void mergeInto(Vec2 pos, ViewIndex&) const;
+  /** Approximate number of bytes used by the memory.*/
+  size_t getMemoryUsage() const;
   static const MapMemory& empty();
 
   template <class Archive> 
@@ -38,7 +42,28 @@ class MapMemory {
   SERIAL_CHECKER;
 
   private:
-  Table<Optional<ViewIndex>> SERIAL(table);
+  /** Highlights are kept with a precision of 1/255, which is enough for drawing.*/
+  struct RememberedSquare {
+    RememberedSquare();
+    /** Indexes in MapMemory::objects, -1 if the layer is empty.*/
+    int objects[EnumInfo<ViewLayer>::size];
+    unsigned char highlight[EnumInfo<HighlightType>::size];
+    bool remembered;
+
+    template <class Archive> 
+    void serialize(Archive& ar, const unsigned int version);
+  };
+  const static int chunkSize = 16;
+  typedef vector<RememberedSquare> Chunk;
+  RememberedSquare& modSquare(Vec2 pos);
+  const RememberedSquare* getSquare(Vec2 pos) const;
+  int addViewObject(const ViewObject&);
+  void insertObject(Vec2 pos, const RememberedSquare&, ViewLayer, ViewIndex&) const;
+
+  unordered_map<Vec2, Chunk> SERIAL(chunks);
+  vector<ViewObject> SERIAL(objects);
+  /** Index of each object in objects, rebuilt after loading.*/
+  unordered_map<ViewObject, int> objectIndex;
 };
 
 #endif
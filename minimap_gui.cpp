@@ -22,37 +22,57 @@
 #include "renderer.h"
 #include "creature.h"
 #include "square.h"
+#include "map_memory.h"
 
-void MinimapGui::renderMap(Renderer& renderer, Vec2 topLeft) {
-  renderer.drawImage(info.bounds.translate(topLeft), mapBufferTex, info.scale);
+void MinimapGui::renderMap(Renderer& renderer, Vec2 topLeft, Rectangle bounds) {
+  double scale = min(double(bounds.getW()) / info.levelPart.getW(),
+      double(bounds.getH()) / info.levelPart.getH());
+  renderer.drawFilledRectangle(bounds.translate(topLeft), colors[ColorId::BLACK]);
+  if (info.levelPart.intersects(Level::getMaxBounds())) {
+    Rectangle part = info.levelPart.intersection(Level::getMaxBounds());
+    Vec2 pos = topLeft + bounds.getTopLeft() + (part.getTopLeft() - info.levelPart.getTopLeft()) * scale;
+    renderer.drawSprite(pos.x, pos.y, part.getPX(), part.getPY(), part.getW(), part.getH(), mapBufferTex,
+        part.getW() * scale, part.getH() * scale);
+  }
   for (Vec2 v : info.roads) {
     Vec2 rrad(1, 1);
-    Vec2 pos = topLeft + v * info.scale;
+    Vec2 pos = topLeft + (v - info.levelPart.getTopLeft()) * scale;
     renderer.drawFilledRectangle(Rectangle(pos - rrad, pos + rrad), colors[ColorId::BROWN]);
   }
   Vec2 rad(3, 3);
-  if (info.player.inRectangle(info.bounds.minusMargin(rad.x)))
-    renderer.drawFilledRectangle(Rectangle(topLeft + info.player - rad,
-          topLeft + info.player + rad), colors[ColorId::BLUE]);
-  for (Vec2 pos : info.enemies)
-    renderer.drawFilledRectangle(Rectangle(topLeft + pos - rad, topLeft + pos + rad), colors[ColorId::RED]);
-  for (auto loc : info.locations)
+  Vec2 player = bounds.getTopLeft() + (info.player - info.levelPart.getTopLeft()) * scale;
+  if (player.inRectangle(bounds.minusMargin(rad.x)))
+    renderer.drawFilledRectangle(Rectangle(topLeft + player - rad,
+          topLeft + player + rad), colors[ColorId::BLUE]);
+  for (Vec2 v : info.enemies) {
+    Vec2 pos = bounds.getTopLeft() + (v - info.levelPart.getTopLeft()) * scale;
+    if (pos.inRectangle(bounds))
+      renderer.drawFilledRectangle(Rectangle(topLeft + pos - rad, topLeft + pos + rad), colors[ColorId::RED]);
+  }
+  for (auto loc : info.locations) {
+    Vec2 pos = bounds.getTopLeft() + loc.pos * scale;
     if (loc.text.empty())
-      renderer.drawText(colors[ColorId::LIGHT_GREEN], topLeft.x + loc.pos.x + 5, topLeft.y + loc.pos.y, "?");
+      renderer.drawText(colors[ColorId::LIGHT_GREEN], topLeft.x + pos.x + 5, topLeft.y + pos.y, "?");
     else {
-      renderer.drawFilledRectangle(topLeft.x + loc.pos.x, topLeft.y + loc.pos.y,
-          topLeft.x + loc.pos.x + renderer.getTextLength(loc.text) + 10, topLeft.y + loc.pos.y + 25,
+      renderer.drawFilledRectangle(topLeft.x + pos.x, topLeft.y + pos.y,
+          topLeft.x + pos.x + renderer.getTextLength(loc.text) + 10, topLeft.y + pos.y + 25,
           transparency(colors[ColorId::BLACK], 130));
-      renderer.drawText(colors[ColorId::WHITE], topLeft.x + loc.pos.x + 5, topLeft.y + loc.pos.y, loc.text);
+      renderer.drawText(colors[ColorId::WHITE], topLeft.x + pos.x + 5, topLeft.y + pos.y, loc.text);
     }
+  }
 }
 
 void MinimapGui::render(Renderer& r) {
-  renderMap(r, getBounds().getTopLeft());
+  renderMap(r, getBounds().getTopLeft(), Rectangle(getBounds().getW(), getBounds().getH()));
 }
 
-MinimapGui::MinimapGui(function<void()> f) : clickFun(f) {
-  mapBuffer.create(Level::getMaxBounds().getW(), Level::getMaxBounds().getH());
+MinimapGui::MinimapGui(function<void()> f) : clickFun(f), stalePixels(Level::getMaxBounds(), true) {
+  mapBuffer.create(Level::getMaxBounds().getW(), Level::getMaxBounds().getH(), colors[ColorId::BLACK]);
+}
+
+void MinimapGui::clear() {
+  lastLevel = nullptr;
+  lastView = nullptr;
 }
 
 bool MinimapGui::onLeftClick(Vec2 v) {
@@ -68,38 +88,56 @@ void MinimapGui::putMapPixel(Vec2 pos, Color col) {
     mapBuffer.setPixel(pos.x, pos.y, col);
 }
 
-void MinimapGui::update(const Level* level, Rectangle levelPart, const CreatureView* creature, bool printLocations) {
-  update(level, levelPart, Rectangle(getBounds().getW(), getBounds().getH()), creature, printLocations);
+void MinimapGui::Update::clear() {
+  pixels.clear();
 }
 
-void MinimapGui::update(const Level* level, Rectangle levelPart, Rectangle bounds, const CreatureView* creature,
+void MinimapGui::refreshPixel(const Level* level, const MapMemory& memory, Vec2 pos, Update& update) {
+  stalePixels[pos] = false;
+  if (!pos.inRectangle(level->getBounds()) || !memory.hasViewIndex(pos)) {
+    update.pixels.emplace_back(pos, colors[ColorId::BLACK]);
+    roads.erase(pos);
+  } else {
+    update.pixels.emplace_back(pos, Tile::getColor(level->getSafeSquare(pos)->getViewObject()));
+    if (level->getSafeSquare(pos)->getName() == "road")
+      roads.insert(pos);
+    else
+      roads.erase(pos);
+  }
+}
+
+void MinimapGui::update(const Level* level, Rectangle levelPart, const CreatureView* creature, Update& update,
     bool printLocations) {
-  double scale = min(double(bounds.getW()) / levelPart.getW(),
-      double(bounds.getH()) / levelPart.getH());
-  info.bounds = bounds;
-  info.scale = scale;
-  info.roads.clear();
-  info.enemies.clear();
-  info.locations.clear();
-  for (Vec2 v : Rectangle(bounds.getW() / scale, bounds.getH() / scale)) {
-    putMapPixel(v, colors[ColorId::BLACK]);
+  PROFILE_ZONE("minimap update");
+  Optional<vector<Rectangle>> changes = level->getChanges(this);
+  if (changes && level == lastLevel && creature == lastView) {
+    for (Rectangle area : *changes)
+      if (area.intersects(Level::getMaxBounds()))
+        for (Vec2 v : area.intersection(Level::getMaxBounds()))
+          stalePixels[v] = true;
+  } else {
+    for (Vec2 v : Level::getMaxBounds())
+      stalePixels[v] = true;
+    roads.clear();
+    lastLevel = level;
+    lastView = creature;
   }
   const MapMemory& memory = creature->getMemory();
-  for (Vec2 v : levelPart) {
-    if (!v.inRectangle(level->getBounds()) || !memory.hasViewIndex(v))
-      putMapPixel(v - levelPart.getTopLeft(), colors[ColorId::BLACK]);
-    else {
-      putMapPixel(v - levelPart.getTopLeft(), Tile::getColor(level->getSafeSquare(v)->getViewObject()));
-      if (level->getSafeSquare(v)->getName() == "road")
-        info.roads.push_back(v - levelPart.getTopLeft());
-    }
-  }
-  info.player = bounds.getTopLeft() + (*creature->getPosition(true) - levelPart.getTopLeft()) * scale;
-  for (const Creature* c : creature->getVisibleEnemies()) {
-    Vec2 pos = bounds.getTopLeft() + (c->getPosition() - levelPart.getTopLeft()) * scale;
-    if (pos.inRectangle(bounds))
-      info.enemies.push_back(pos);
-  }
+  if (levelPart.intersects(Level::getMaxBounds()))
+    for (Vec2 v : levelPart.intersection(Level::getMaxBounds()))
+      if (stalePixels[v])
+        refreshPixel(level, memory, v, update);
+  MinimapInfo& info = update.info;
+  info.levelPart = levelPart;
+  info.player = *creature->getPosition(true);
+  info.enemies.clear();
+  for (const Creature* c : creature->getVisibleEnemies())
+    info.enemies.push_back(c->getPosition());
+  info.roads.clear();
+  for (Vec2 v : roads)
+    if (v.inRectangle(levelPart))
+      info.roads.push_back(v);
+  info.locations.clear();
   if (printLocations)
     for (const Location* loc : level->getAllLocations()) {
       bool seen = false;
@@ -108,16 +146,29 @@ void MinimapGui::update(const Level* level, Rectangle levelPart, Rectangle bound
           seen = true;
           break;
         }
-      if (loc->isMarkedAsSurprise() && !seen) {
-        Vec2 pos = bounds.getTopLeft() + loc->getBounds().middle() * scale;
-        info.locations.push_back({pos, ""});
-      }
-      if (loc->hasName() && seen) {
-        Vec2 pos = bounds.getTopLeft() + loc->getBounds().getBottomRight() * scale;
-        info.locations.push_back({pos, loc->getName()});
-      }
+      if (loc->isMarkedAsSurprise() && !seen)
+        info.locations.push_back({loc->getBounds().middle(), ""});
+      if (loc->hasName() && seen)
+        info.locations.push_back({loc->getBounds().getBottomRight(), loc->getName()});
     }
-  mapBufferTex.loadFromImage(mapBuffer);
+}
+
+void MinimapGui::applyUpdate(const Update& update) {
+  info = update.info;
+  int minY = Level::getMaxBounds().getKY();
+  int maxY = -1;
+  for (auto& pixel : update.pixels) {
+    putMapPixel(pixel.first, pixel.second);
+    minY = min(minY, pixel.first.y);
+    maxY = max(maxY, pixel.first.y);
+  }
+  if (mapBufferTex.getSize().x == 0)
+    mapBufferTex.loadFromImage(mapBuffer);
+  else if (maxY >= minY) {
+    // Rows of the image are contiguous, so the band of changed rows can be uploaded without copying.
+    int width = mapBuffer.getSize().x;
+    mapBufferTex.update(mapBuffer.getPixelsPtr() + 4 * width * minY, width, maxY - minY + 1, 0, minY);
+  }
 }
 
 void MinimapGui::presentMap(const CreatureView* creature, Rectangle bounds, Renderer& r,
@@ -125,9 +176,12 @@ void MinimapGui::presentMap(const CreatureView* creature, Rectangle bounds, Rend
   const Level* level = creature->getLevel();
   double scale = min(double(bounds.getW()) / level->getBounds().getW(),
       double(bounds.getH()) / level->getBounds().getH());
+  Update mapUpdate;
   while (1) {
-    update(level, level->getBounds(), Rectangle(bounds.getW(), bounds.getH()), creature, true);
-    renderMap(r, Vec2(0, 0));
+    mapUpdate.clear();
+    update(level, level->getBounds(), creature, mapUpdate, true);
+    applyUpdate(mapUpdate);
+    renderMap(r, Vec2(0, 0), Rectangle(bounds.getW(), bounds.getH()));
     r.drawAndClearBuffer();
     Event event;
     while (r.pollEvent(event)) {
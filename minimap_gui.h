@@ -22,42 +22,67 @@
 class Level;
 class CreatureView;
 class Renderer;
+class MapMemory;
 
 class MinimapGui : public GuiElem {
   public:
 
   MinimapGui(function<void()> clickFun);
 
-  void update(const Level* level, Rectangle levelPart, const CreatureView* creature, bool printLocations = false);
-  void update(const Level* level, Rectangle levelPart, Rectangle bounds,
-      const CreatureView* creature, bool printLocations = false);
+  /** What the minimap shows, in level coordinates.*/
+  struct MinimapInfo {
+    Rectangle levelPart;
+    vector<Vec2> enemies;
+    vector<Vec2> roads;
+    Vec2 player;
+    struct Location {
+      Vec2 pos;
+      string text;
+    };
+    vector<Location> locations;
+  };
+
+  /** Minimap changes collected on the game thread and applied on the render thread. Repainted pixels
+      are appended until the render thread picks the update up.*/
+  struct Update {
+    MinimapInfo info;
+    vector<pair<Vec2, Color>> pixels;
+
+    void clear();
+  };
+
+  /** Called on the game thread.*/
+  void update(const Level* level, Rectangle levelPart, const CreatureView* creature, Update&,
+      bool printLocations = false);
+  /** Called on the render thread.*/
+  void applyUpdate(const Update&);
   void presentMap(const CreatureView*, Rectangle bounds, Renderer&, function<void(double, double)> clickFun);
+  /** Forgets the painted pixels, so that the next update repaints the whole level.*/
+  void clear();
 
   virtual void render(Renderer&) override;
   virtual bool onLeftClick(Vec2) override;
 
   private:
 
-  void renderMap(Renderer&, Vec2 topLeft);
+  void renderMap(Renderer&, Vec2 topLeft, Rectangle bounds);
   void putMapPixel(Vec2 pos, Color col);
+  void refreshPixel(const Level*, const MapMemory&, Vec2 pos, Update&);
 
-  struct MinimapInfo {
-    Rectangle bounds;
-    vector<Vec2> roads;
-    vector<Vec2> enemies;
-    Vec2 player;
-    double scale;
-    struct Location {
-      Vec2 pos;
-      string text;
-    };
-    vector<Location> locations;
-  } info;
+  MinimapInfo info;
 
   function<void()> clickFun;
 
+  /** The map buffer holds one pixel per square of the level. Pixels are repainted when the level's
+      change journal marks them, but only once they are shown, and only the rows that changed are
+      uploaded to the texture. The buffer and texture belong to the render thread, the rest of the
+      members below to the game thread.*/
   sf::Texture mapBufferTex;
   sf::Image mapBuffer;
+  Table<bool> stalePixels;
+  set<Vec2> roads;
+  const Level* lastLevel = nullptr;
+  const CreatureView* lastView = nullptr;
 };
 
 #endif
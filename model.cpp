@@ -63,7 +63,10 @@ void Model::serialize(Archive& ar, const unsigned int version) {
 }
 
 SERIALIZABLE(Model);
-SERIALIZATION_CONSTRUCTOR_IMPL(Model);
+
+Model::Model() {
+  updateSunlightInfo();
+}
 
 bool Model::isTurnBased() {
   return !playerControl || playerControl->isTurnBased();
@@ -73,6 +76,8 @@ const double dayLength = 1500;
 const double nightLength = 1500;
 
 const double duskLength  = 180;
+/** The light changes in this many steps at dusk and dawn, and every step repaints the levels.*/
+const int lightSteps = 30;
 
 MusicType Model::getCurrentMusic() const {
   return musicType;
@@ -87,32 +92,34 @@ const Model::SunlightInfo& Model::getSunlightInfo() const {
 }
 
 void Model::updateSunlightInfo() {
-  double d = 0;
+  // Skip the full days that have passed, the cycle repeats every dayLength + nightLength.
+  double d = currentTime - fmod(currentTime, dayLength + nightLength);
 /*  if (options->getBoolValue(OptionId::START_WITH_NIGHT))
     d = -dayLength + 10;*/
   while (1) {
     d += dayLength;
     if (d > currentTime) {
       sunlightInfo = {1, d - currentTime, SunlightInfo::DAY};
-      return;
+      break;
     }
     d += duskLength;
     if (d > currentTime) {
       sunlightInfo = {(d - currentTime) / duskLength, d + nightLength - duskLength - currentTime,
         SunlightInfo::NIGHT};
-      return;
+      break;
     }
     d += nightLength - 2 * duskLength;
     if (d > currentTime) {
       sunlightInfo = {0, d + duskLength - currentTime, SunlightInfo::NIGHT};
-      return;
+      break;
     }
     d += duskLength;
     if (d > currentTime) {
       sunlightInfo = {1 - (d - currentTime) / duskLength, d - currentTime, SunlightInfo::NIGHT};
-      return;
+      break;
     }
   }
+  sunlightInfo.lightAmount = round(sunlightInfo.lightAmount * lightSteps) / lightSteps;
 }
 
 const char* Model::SunlightInfo::getText() {
@@ -131,6 +138,7 @@ const Creature* Model::getPlayer() const {
 }
 
 Optional<Model::ExitInfo> Model::update(double totalTime) {
+  PROFILE_ZONE("Model::update");
   if (addHero) {
     CHECK(playerControl && playerControl->isRetired());
     landHeroPlayer();
@@ -146,7 +154,7 @@ Optional<Model::ExitInfo> Model::update(double totalTime) {
   do {
     Creature* creature = timeQueue.getNextCreature();
     CHECK(creature) << "No more creatures";
-    Debug() << creature->getName().the() << " moving now " << creature->getTime();
+    LOG(TRACE, MODEL) << creature->getName().the() << " moving now " << creature->getTime();
     currentTime = creature->getTime();
     if (playerControl && !playerControl->isTurnBased()) {
       while (1) {
@@ -163,7 +171,7 @@ Optional<Model::ExitInfo> Model::update(double totalTime) {
     if (currentTime > totalTime)
       return Nothing();
     if (currentTime >= lastTick + 1) {
-      MEASURE({ tick(currentTime); }, "ticking time");
+      tick(currentTime);
     }
     if (!creature->isDead()) {
 #ifndef RELEASE
@@ -197,11 +205,15 @@ const vector<Collective*> Model::getMainVillains() const {
 }
 
 void Model::tick(double time) {
-  auto previous = sunlightInfo.state;
+  PROFILE_ZONE("Model::tick");
+  auto previous = sunlightInfo;
   updateSunlightInfo();
-  if (previous != sunlightInfo.state)
+  if (previous.state != sunlightInfo.state)
     GlobalEvents.addSunlightChangeEvent();
-  Debug() << "Turn " << time;
+  if (previous.lightAmount != sunlightInfo.lightAmount)
+    for (PLevel& l : levels)
+      l->updateSunlight(previous.lightAmount);
+  LOG(INFO, MODEL) << "Turn " << time;
   for (Creature* c : timeQueue.getAllCreatures()) {
     c->tick(time);
   }
@@ -378,8 +390,9 @@ string Model::getShortGameIdentifier() const {
 
 void Model::onKilledLeaderEvent(const Collective* victim, const Creature* leader) {
   if (playerControl && playerControl->isRetired() && playerCollective == victim) {
-    const Creature* c = getPlayer();
-    killedKeeper(c->getNameAndTitle(), leader->getNameAndTitle(), worldName, c->getKills(), c->getPoints());
+    // The hero might not be controlled by the player, eg. in a headless benchmark.
+    if (const Creature* c = getPlayer())
+      killedKeeper(c->getNameAndTitle(), leader->getNameAndTitle(), worldName, c->getKills(), c->getPoints());
   }
 }
 
@@ -869,8 +882,9 @@ void Model::conquered(const string& title, const string& land, vector<const Crea
   for (string stat : Statistics::getText())
     text += stat + "\n";
   view->presentText("Victory", text);
-  ofstream("highscore.txt", std::ofstream::out | std::ofstream::app)
-    << title << "," << "conquered the land of " + land + "," << points << std::endl;
+  if (recordHighscores)
+    ofstream("highscore.txt", std::ofstream::out | std::ofstream::app)
+      << title << "," << "conquered the land of " + land + "," << points << std::endl;
   showHighscore(view, true);
 }
 
@@ -883,8 +897,9 @@ void Model::killedKeeper(const string& title, const string& keeper, const string
   for (string stat : Statistics::getText())
     text += stat + "\n";
   view->presentText("Victory", text);
-  ofstream("highscore.txt", std::ofstream::out | std::ofstream::app)
-    << title << "," << "freed the land of " + land + "," << points << std::endl;
+  if (recordHighscores)
+    ofstream("highscore.txt", std::ofstream::out | std::ofstream::app)
+      << title << "," << "freed the land of " + land + "," << points << std::endl;
   showHighscore(view, true);
 }
 
@@ -900,8 +915,9 @@ void Model::gameOver(const Creature* creature, int numKills, const string& enemi
   for (string stat : Statistics::getText())
     text += stat + "\n";
   view->presentText("Game over", text);
-  ofstream("highscore.txt", std::ofstream::out | std::ofstream::app)
-    << creature->getNameAndTitle() << (killer.empty() ? "" : ", killed by " + killer) << "," << points << std::endl;
+  if (recordHighscores)
+    ofstream("highscore.txt", std::ofstream::out | std::ofstream::app)
+      << creature->getNameAndTitle() << (killer.empty() ? "" : ", killed by " + killer) << "," << points << std::endl;
   showHighscore(view, true);
   exitInfo = ExitInfo::abandonGame();
 }
@@ -106,6 +106,8 @@ class Model {
   Encyclopedia keeperopedia;
 
   private:
+  friend class Benchmark;
+
   REGISTER_HANDLER(KilledLeaderEvent, const Collective*, const Creature*);
 
   Model(View* view, const string& worldName);
@@ -138,6 +140,7 @@ class Model {
   string SERIAL(worldName);
   MusicType SERIAL(musicType);
   Optional<ExitInfo> exitInfo;
+  bool recordHighscores = true;
 };
 
 #endif
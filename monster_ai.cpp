@@ -72,7 +72,13 @@ SERIALIZATION_CONSTRUCTOR_IMPL(Behaviour);
 const Creature* Behaviour::getClosestEnemy() {
   int dist = 1000000000;
   const Creature* result = nullptr;
-  for (const Creature* other : creature->getVisibleEnemies()) {
+  // Creatures are checked closest first, and attackers that weren't seen are compared afterwards.
+  vector<const Creature*> candidates = creature->getUnknownAttacker();
+  for (const Creature* other : creature->getLevel()->getClosestCreatures(creature->getPosition(),
+        FieldOfView::sightRange, 1, [this] (const Creature* c) {
+          return c->getTribe() != Tribe::get(TribeId::PEST) && creature->isEnemy(c) && creature->canSee(c);}))
+    candidates.push_back(other);
+  for (const Creature* other : candidates) {
     if ((other->getPosition() - creature->getPosition()).length8() < dist
         && other->getTribe() != Tribe::get(TribeId::PEST)) {
       result = other;
@@ -85,8 +91,9 @@ const Creature* Behaviour::getClosestEnemy() {
 Item* Behaviour::getBestWeapon() {
   Item* best = nullptr;
   int damage = -1;
-  for (Item* item : creature->getEquipment().getItems(Item::classPredicate(ItemClass::WEAPON))) 
-    if (item->getModifier(ModifierType::DAMAGE) > damage) {
+  // Called for every item the creature stands on, so the equipment isn't copied.
+  for (Item* item : creature->getEquipment().getAllItems())
+    if (item->getClass() == ItemClass::WEAPON && item->getModifier(ModifierType::DAMAGE) > damage) {
       damage = item->getModifier(ModifierType::DAMAGE);
       best = item;
     }
@@ -383,7 +390,7 @@ class Fighter : public Behaviour {
         weight = 1;
       if (other->isAffected(LastingEffect::SLEEP) || other->isStationary())
         weight = 0;
-      Debug() << creature->getName().bare() << " panic weight " << weight;
+      LOG(TRACE, CREATURE) << creature->getName().bare() << " panic weight " << weight;
       if (weight >= 0.5) {
         double dist = creature->getPosition().dist8(other->getPosition());
         if (dist < 7) {
@@ -418,7 +425,7 @@ class Fighter : public Behaviour {
   }
 
   virtual double itemValue(const Item* item) {
-    if (contains<EffectType>({
+    static const vector<EffectType> usefulEffects {
           EffectType(EffectId::LASTING, LastingEffect::INVISIBLE),
           EffectType(EffectId::LASTING, LastingEffect::SLOWED),
           EffectType(EffectId::LASTING, LastingEffect::BLIND),
@@ -428,8 +435,8 @@ class Fighter : public Behaviour {
           EffectId::CURE_POISON,
           EffectId::TELEPORT,
           EffectType(EffectId::LASTING, LastingEffect::STR_BONUS),
-          EffectType(EffectId::LASTING, LastingEffect::DEX_BONUS)},
-          item->getEffectType()))
+          EffectType(EffectId::LASTING, LastingEffect::DEX_BONUS)};
+    if (contains<EffectType>(usefulEffects, item->getEffectType()))
       return 1;
     if (item->getClass() == ItemClass::AMMO && creature->getSkillValue(Skill::get(SkillId::ARCHERY)) > 0)
       return 0.1;
@@ -541,7 +548,7 @@ class Fighter : public Behaviour {
     CHECK(other);
     if (other->isInvincible())
       return NoMove;
-    Debug() << creature->getName().bare() << " enemy " << other->getName().bare();
+    LOG(TRACE, CREATURE) << creature->getName().bare() << " enemy " << other->getName().bare();
     Vec2 enemyDir = (other->getPosition() - creature->getPosition());
     distance = enemyDir.length8();
     if (creature->isHumanoid() && !creature->getWeapon()) {
@@ -926,20 +933,22 @@ MonsterAI::MonsterAI(Creature* c, const vector<Behaviour*>& beh, const vector<in
 }
 
 void MonsterAI::makeMove() {
-  vector<pair<MoveInfo, int>> moves;
+  pickUpOptions.clear();
+  // Picking up is possible for any of the options, so the actions don't have to be built to compare them.
+  if (pickItems && creature->isHumanoid()) {
+    pickUpStacks.reset(creature->getPickUpOptions());
+    for (int i : Range(pickUpStacks.getNumStacks()))
+      if (!pickUpStacks.getFirst(i)->getShopkeeper() && creature->canCarry(pickUpStacks.getWeight(i)))
+        pickUpOptions.push_back(i);
+  }
+  moves.clear();
   for (int i : All(behaviours)) {
     MoveInfo move = behaviours[i]->getMove();
     move.value *= weights[i];
-    moves.emplace_back(move, weights[i]);
-    if (pickItems) {
-      for (auto elem : Item::stackItems(creature->getPickUpOptions())) {
-        Item* item = elem.second[0];
-        if (!item->getShopkeeper() && creature->pickUp(elem.second))
-          moves.emplace_back(
-              MoveInfo({ behaviours[i]->itemValue(item) * weights[i], creature->pickUp(elem.second)}),
-              weights[i]);
-      }
-    }
+    moves.push_back({move, weights[i], -1});
+    for (int stack : pickUpOptions)
+      moves.push_back({NoMove.setValue(behaviours[i]->itemValue(pickUpStacks.getFirst(stack)) * weights[i]),
+          weights[i], stack});
   }
   /*vector<Item*> inventory = creature->getEquipment().getItems([this](Item* item) { return !creature->getEquipment().isEquiped(item);});
   for (Item* item : inventory) {
@@ -952,16 +961,18 @@ void MonsterAI::makeMove() {
         creature->drop({item});
       }});
   }*/
-  MoveInfo winner = NoMove;
+  int winner = -1;
   for (int i : All(moves)) {
-    MoveInfo& move = moves[i].first;
-    if (move.value > winner.value)
-      winner = move;
-    if (i < moves.size() - 1 && move.value > moves[i + 1].second)
+    if (moves[i].move.value > (winner == -1 ? NoMove.value : moves[winner].move.value))
+      winner = i;
+    if (i < moves.size() - 1 && moves[i].move.value > moves[i + 1].weight)
       break;
   }
-  CHECK(winner.value > 0);
-  winner.move.perform();
+  CHECK(winner > -1);
+  if (moves[winner].pickUpStack > -1)
+    creature->pickUp(pickUpStacks.getItems(moves[winner].pickUpStack)).perform();
+  else
+    moves[winner].move.move.perform();
 }
 
 PMonsterAI MonsterAIFactory::getMonsterAI(Creature* c) {
@@ -18,6 +18,7 @@
 
 #include "location.h"
 #include "creature_action.h"
+#include "item.h"
 
 class Creature;
 
@@ -34,7 +35,7 @@ struct MoveInfo {
     return move;
   }
 
-  MoveInfo setValue(double v) {
+  MoveInfo setValue(double v) const {
     MoveInfo ret(*this);
     ret.value = v;
     return ret;
@@ -69,6 +70,17 @@ class MonsterAI {
   vector<int> SERIAL(weights);
   Creature* SERIAL(creature);
   bool SERIAL(pickItems);
+  /** Scratch space for makeMove(), kept between moves so that its storage is reused.*/
+  ItemStacks pickUpStacks;
+  vector<int> pickUpOptions;
+  /** A behaviour's move or, if pickUpStack isn't -1, picking up that stack. The pick up action is only built
+      for the winner.*/
+  struct Candidate {
+    MoveInfo move;
+    int weight;
+    int pickUpStack;
+  };
+  vector<Candidate> moves;
 };
 
 class Collective;
@@ -31,3 +31,18 @@ bool MovementType::canEnter(const MovementType& t) const {
       return true;
   return false;
 }
+
+MovementType MovementType::getWithoutTribe() const {
+  return MovementType(nullptr, traits);
+}
+
+bool MovementType::operator == (const MovementType& other) const {
+  return traits == other.traits && tribe == other.tribe;
+}
+
+bool MovementType::operator < (const MovementType& other) const {
+  for (MovementTrait t : ENUM_ALL(MovementTrait))
+    if (traits[t] != other.traits[t])
+      return traits[t] < other.traits[t];
+  return tribe < other.tribe;
+}
@@ -20,6 +20,10 @@ class MovementType {
   bool hasTrait(MovementTrait) const;
   /** Returns if the argument can enter square define by this. The relation is not symmetric.*/
   bool canEnter(const MovementType&) const;
+  /** Returns the same movement traits without a tribe, which can enter squares restricted to any tribe.*/
+  MovementType getWithoutTribe() const;
+  bool operator == (const MovementType&) const;
+  bool operator < (const MovementType&) const;
 
   template <class Archive>
   void serialize(Archive& ar, const unsigned int version);
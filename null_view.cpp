@@ -0,0 +1,122 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+#include "null_view.h"
+
+NullView::NullView() : startTime(std::chrono::steady_clock::now()) {
+}
+
+void NullView::initialize() {
+}
+
+void NullView::reset() {
+}
+
+void NullView::displaySplash(const ProgressMeter&, View::SplashType) {
+}
+
+void NullView::clearSplash() {
+}
+
+void NullView::close() {
+}
+
+void NullView::refreshView() {
+}
+
+double NullView::getGameSpeed() {
+  return 0.025;
+}
+
+void NullView::updateView(const CreatureView*) {
+}
+
+void NullView::drawLevelMap(const CreatureView*) {
+}
+
+void NullView::resetCenter() {
+}
+
+UserInput NullView::getAction() {
+  return UserInput(UserInputId::IDLE);
+}
+
+bool NullView::travelInterrupt() {
+  return false;
+}
+
+Optional<int> NullView::chooseFromList(const string& title, const vector<ListElem>& options, int index,
+    MenuType, int* scrollPos, Optional<UserInputId> exitAction) {
+  return Nothing();
+}
+
+Optional<Vec2> NullView::chooseDirection(const string& message) {
+  return Nothing();
+}
+
+bool NullView::yesOrNoPrompt(const string& message) {
+  return false;
+}
+
+void NullView::presentText(const string& title, const string& text) {
+}
+
+void NullView::presentList(const string& title, const vector<ListElem>& options, bool scrollDown,
+    MenuType, Optional<UserInputId> exitAction) {
+}
+
+Optional<int> NullView::getNumber(const string& title, int min, int max, int increments) {
+  return Nothing();
+}
+
+Optional<string> NullView::getText(const string& title, const string& value, int maxLength,
+    const string& hint) {
+  return Nothing();
+}
+
+void NullView::animateObject(vector<Vec2> trajectory, ViewObject object) {
+}
+
+void NullView::animation(Vec2 pos, AnimationId) {
+}
+
+int NullView::getTimeMilliAbsolute() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime).count();
+}
+
+int NullView::getTimeMilli() {
+  if (lastPause > -1)
+    return lastPause - pausedTime;
+  else
+    return getTimeMilliAbsolute() - pausedTime;
+}
+
+void NullView::stopClock() {
+  if (lastPause < 0)
+    lastPause = getTimeMilliAbsolute();
+}
+
+void NullView::continueClock() {
+  if (lastPause > -1) {
+    pausedTime += getTimeMilliAbsolute() - lastPause;
+    lastPause = -1;
+  }
+}
+
+bool NullView::isClockStopped() {
+  return lastPause > -1;
+}
@@ -0,0 +1,64 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _NULL_VIEW
+#define _NULL_VIEW
+
+#include "util.h"
+#include "view.h"
+
+/** A view that displays nothing and never gets any input. Used to run the model headless, eg. in benchmarks.
+    Prompts are answered with their default or cancelled. See view.h for documentation.*/
+class NullView : public View {
+  public:
+  NullView();
+
+  virtual void initialize() override;
+  virtual void reset() override;
+  virtual void displaySplash(const ProgressMeter&, View::SplashType) override;
+  virtual void clearSplash() override;
+  virtual void close() override;
+  virtual void refreshView() override;
+  virtual double getGameSpeed() override;
+  virtual void updateView(const CreatureView*) override;
+  virtual void drawLevelMap(const CreatureView*) override;
+  virtual void resetCenter() override;
+  virtual UserInput getAction() override;
+  virtual bool travelInterrupt() override;
+  virtual Optional<int> chooseFromList(const string& title, const vector<ListElem>& options, int index,
+      MenuType, int* scrollPos, Optional<UserInputId> exitAction) override;
+  virtual Optional<Vec2> chooseDirection(const string& message) override;
+  virtual bool yesOrNoPrompt(const string& message) override;
+  virtual void presentText(const string& title, const string& text) override;
+  virtual void presentList(const string& title, const vector<ListElem>& options, bool scrollDown,
+      MenuType, Optional<UserInputId> exitAction) override;
+  virtual Optional<int> getNumber(const string& title, int min, int max, int increments) override;
+  virtual Optional<string> getText(const string& title, const string& value, int maxLength,
+      const string& hint) override;
+  virtual void animateObject(vector<Vec2> trajectory, ViewObject object) override;
+  virtual void animation(Vec2 pos, AnimationId) override;
+  virtual int getTimeMilli() override;
+  virtual int getTimeMilliAbsolute() override;
+  virtual void stopClock() override;
+  virtual void continueClock() override;
+  virtual bool isClockStopped() override;
+
+  private:
+  std::chrono::steady_clock::time_point startTime;
+  int pausedTime = 0;
+  int lastPause = -1;
+};
+
+#endif
@@ -176,7 +176,7 @@ vector<Deity*> generateDeities() {
     ret.push_back(new Deity(deity, gend, ep, elem.first)); 
   }
   for (Deity* deity : ret)
-    Debug() << deity->getName() + " lives in " + deity->getHabitatString() + ". " 
+    LOG(INFO, GENERAL) << deity->getName() + " lives in " + deity->getHabitatString() + ". " 
       << deity->getGender().he() << " is the " << deity->getGender().god() 
           << " of " << deity->getEpithetsString();
   return ret;
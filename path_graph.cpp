@@ -0,0 +1,233 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+#include "path_graph.h"
+
+static Rectangle getChunkGrid(Rectangle bounds) {
+  return Rectangle((bounds.getW() + PathGraph::chunkSize - 1) / PathGraph::chunkSize,
+      (bounds.getH() + PathGraph::chunkSize - 1) / PathGraph::chunkSize);
+}
+
+PathGraph::PathGraph(Rectangle b, function<bool(Vec2)> passable) : bounds(b), passableFun(passable),
+    sectors(bounds), chunkBounds(getChunkGrid(bounds)), rightPortals(chunkBounds),
+    bottomPortals(chunkBounds), edges(chunkBounds), dirtyRight(chunkBounds, true),
+    dirtyBottom(chunkBounds, true), dirtyChunk(chunkBounds, true) {
+  for (Vec2 v : bounds)
+    if (isPassable(v))
+      sectors.add(v);
+}
+
+bool PathGraph::isPassable(Vec2 pos) const {
+  return passableFun(pos);
+}
+
+Vec2 PathGraph::getChunk(Vec2 pos) const {
+  return Vec2((pos.x - bounds.getPX()) / chunkSize, (pos.y - bounds.getPY()) / chunkSize);
+}
+
+Rectangle PathGraph::getChunkBounds(Vec2 chunk) const {
+  Vec2 corner = Vec2(bounds.getPX(), bounds.getPY()) + chunk * chunkSize;
+  return Rectangle(corner, corner + Vec2(chunkSize, chunkSize)).intersection(bounds);
+}
+
+bool PathGraph::isConnected(Vec2 from, Vec2 to) const {
+  if (!isPassable(from) || sectors.same(from, to))
+    return true;
+  // The target itself doesn't have to be enterable, it's enough to get next to it.
+  for (Vec2 v : to.neighbors8())
+    if (v.inRectangle(bounds) && sectors.same(from, v))
+      return true;
+  return false;
+}
+
+map<Vec2, int> PathGraph::getDistances(Vec2 from, Rectangle area) const {
+  map<Vec2, int> ret {{from, 0}};
+  queue<Vec2> q;
+  q.push(from);
+  while (!q.empty()) {
+    Vec2 pos = q.front();
+    q.pop();
+    for (Vec2 v : pos.neighbors8())
+      if (v.inRectangle(area) && !ret.count(v) && isPassable(v)) {
+        ret[v] = ret.at(pos) + 1;
+        q.push(v);
+      }
+  }
+  return ret;
+}
+
+vector<pair<Vec2, Vec2>> PathGraph::findPortals(Vec2 chunk, Vec2 dir) const {
+  vector<pair<Vec2, Vec2>> ret;
+  if (!(chunk + dir).inRectangle(chunkBounds))
+    return ret;
+  Rectangle area = getChunkBounds(chunk);
+  // The border is walked along its length, and every run of passable pairs gets one portal in the middle.
+  Vec2 along = dir.x != 0 ? Vec2(0, 1) : Vec2(1, 0);
+  Vec2 start = dir.x != 0 ? Vec2(area.getKX() - 1, area.getPY()) : Vec2(area.getPX(), area.getKY() - 1);
+  int length = dir.x != 0 ? area.getH() : area.getW();
+  int runStart = -1;
+  for (int i = 0; i <= length; ++i) {
+    Vec2 pos = start + along * i;
+    if (i < length && isPassable(pos) && isPassable(pos + dir)) {
+      if (runStart == -1)
+        runStart = i;
+    } else if (runStart > -1) {
+      Vec2 portal = start + along * ((runStart + i - 1) / 2);
+      ret.emplace_back(portal, portal + dir);
+      runStart = -1;
+    }
+  }
+  return ret;
+}
+
+vector<Vec2> PathGraph::getPortals(Vec2 chunk) const {
+  set<Vec2> ret;
+  for (auto& elem : rightPortals[chunk])
+    ret.insert(elem.first);
+  for (auto& elem : bottomPortals[chunk])
+    ret.insert(elem.first);
+  if ((chunk - Vec2(1, 0)).inRectangle(chunkBounds))
+    for (auto& elem : rightPortals[chunk - Vec2(1, 0)])
+      ret.insert(elem.second);
+  if ((chunk - Vec2(0, 1)).inRectangle(chunkBounds))
+    for (auto& elem : bottomPortals[chunk - Vec2(0, 1)])
+      ret.insert(elem.second);
+  return vector<Vec2>(ret.begin(), ret.end());
+}
+
+vector<Vec2> PathGraph::getCrossings(Vec2 portal) const {
+  vector<Vec2> ret;
+  Vec2 chunk = getChunk(portal);
+  for (auto& elem : rightPortals[chunk])
+    if (elem.first == portal)
+      ret.push_back(elem.second);
+  for (auto& elem : bottomPortals[chunk])
+    if (elem.first == portal)
+      ret.push_back(elem.second);
+  if ((chunk - Vec2(1, 0)).inRectangle(chunkBounds))
+    for (auto& elem : rightPortals[chunk - Vec2(1, 0)])
+      if (elem.second == portal)
+        ret.push_back(elem.first);
+  if ((chunk - Vec2(0, 1)).inRectangle(chunkBounds))
+    for (auto& elem : bottomPortals[chunk - Vec2(0, 1)])
+      if (elem.second == portal)
+        ret.push_back(elem.first);
+  return ret;
+}
+
+void PathGraph::updateChunk(Vec2 chunk) {
+  Rectangle area = getChunkBounds(chunk);
+  vector<Vec2> portals = getPortals(chunk);
+  edges[chunk].clear();
+  for (Vec2 portal : portals) {
+    map<Vec2, int> distances = getDistances(portal, area);
+    for (Vec2 other : portals)
+      if (other != portal && distances.count(other))
+        edges[chunk][portal].emplace_back(other, distances.at(other));
+  }
+}
+
+void PathGraph::update() {
+  if (!dirty)
+    return;
+  for (Vec2 chunk : chunkBounds) {
+    if (dirtyRight[chunk])
+      rightPortals[chunk] = findPortals(chunk, Vec2(1, 0));
+    if (dirtyBottom[chunk])
+      bottomPortals[chunk] = findPortals(chunk, Vec2(0, 1));
+    dirtyRight[chunk] = dirtyBottom[chunk] = false;
+  }
+  for (Vec2 chunk : chunkBounds)
+    if (dirtyChunk[chunk]) {
+      updateChunk(chunk);
+      dirtyChunk[chunk] = false;
+    }
+  dirty = false;
+}
+
+void PathGraph::squareChanged(Vec2 pos) {
+  if (isPassable(pos))
+    sectors.add(pos);
+  else
+    sectors.remove(pos);
+  Vec2 chunk = getChunk(pos);
+  Rectangle area = getChunkBounds(chunk);
+  dirtyChunk[chunk] = true;
+  // A square on the chunk's edge can also move the portals shared with the neighboring chunk.
+  if (pos.x == area.getKX() - 1 && (chunk + Vec2(1, 0)).inRectangle(chunkBounds)) {
+    dirtyRight[chunk] = true;
+    dirtyChunk[chunk + Vec2(1, 0)] = true;
+  }
+  if (pos.y == area.getKY() - 1 && (chunk + Vec2(0, 1)).inRectangle(chunkBounds)) {
+    dirtyBottom[chunk] = true;
+    dirtyChunk[chunk + Vec2(0, 1)] = true;
+  }
+  if (pos.x == area.getPX() && (chunk - Vec2(1, 0)).inRectangle(chunkBounds)) {
+    dirtyRight[chunk - Vec2(1, 0)] = true;
+    dirtyChunk[chunk - Vec2(1, 0)] = true;
+  }
+  if (pos.y == area.getPY() && (chunk - Vec2(0, 1)).inRectangle(chunkBounds)) {
+    dirtyBottom[chunk - Vec2(0, 1)] = true;
+    dirtyChunk[chunk - Vec2(0, 1)] = true;
+  }
+  dirty = true;
+}
+
+Optional<vector<Vec2>> PathGraph::getWaypoints(Vec2 from, Vec2 to) {
+  update();
+  Vec2 fromChunk = getChunk(from);
+  Vec2 toChunk = getChunk(to);
+  map<Vec2, int> fromDistances = getDistances(from, getChunkBounds(fromChunk));
+  map<Vec2, int> toDistances = getDistances(to, getChunkBounds(toChunk));
+  map<Vec2, int> distance {{from, 0}};
+  map<Vec2, Vec2> parent;
+  priority_queue<pair<int, Vec2>, vector<pair<int, Vec2>>, std::greater<pair<int, Vec2>>> q;
+  q.push({(to - from).length8(), from});
+  auto relax = [&](Vec2 pos, Vec2 next, int length) {
+    int dist = distance.at(pos) + length;
+    if (!distance.count(next) || distance.at(next) > dist) {
+      distance[next] = dist;
+      parent[next] = pos;
+      q.push({dist + (to - next).length8(), next});
+    }
+  };
+  while (!q.empty()) {
+    Vec2 pos = q.top().second;
+    int priority = q.top().first;
+    q.pop();
+    if (priority > distance.at(pos) + (to - pos).length8())
+      continue;
+    if (pos == to) {
+      vector<Vec2> ret {to};
+      while (ret.back() != from)
+        ret.push_back(parent.at(ret.back()));
+      return vector<Vec2>(ret.rbegin(), ret.rend());
+    }
+    Vec2 chunk = getChunk(pos);
+    if (chunk == toChunk && toDistances.count(pos))
+      relax(pos, to, toDistances.at(pos));
+    if (pos == from)
+      for (Vec2 portal : getPortals(fromChunk))
+        if (fromDistances.count(portal))
+          relax(pos, portal, fromDistances.at(portal));
+    if (edges[chunk].count(pos))
+      for (auto& edge : edges[chunk].at(pos))
+        relax(pos, edge.first, edge.second);
+    for (Vec2 next : getCrossings(pos))
+      relax(pos, next, 1);
+  }
+  return Nothing();
+}
@@ -0,0 +1,68 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _PATH_GRAPH_H
+#define _PATH_GRAPH_H
+
+#include "util.h"
+#include "sectors.h"
+
+/** Coarse map of a level for a single kind of movement. The level is split into square chunks, which
+    are connected through portals placed on the passable parts of their borders. Long paths are first
+    planned on the portals and only refined locally.*/
+class PathGraph {
+  public:
+  /** The graph only needs to know which squares can be passed, eventually by breaking through them.*/
+  PathGraph(Rectangle bounds, function<bool(Vec2)> passable);
+
+  /** Returns false only if there is certainly no way between the squares. Runs in constant time.*/
+  bool isConnected(Vec2 from, Vec2 to) const;
+
+  /** Returns a coarse path that starts at \paramname{from}, ends at \paramname{to} and passes through
+      portals between them. Returns Nothing() if no such path was found.*/
+  Optional<vector<Vec2>> getWaypoints(Vec2 from, Vec2 to);
+
+  /** Updates the portals and connectivity after movement rules changed on the square.*/
+  void squareChanged(Vec2 pos);
+
+  static const int chunkSize = 16;
+
+  private:
+  bool isPassable(Vec2) const;
+  Vec2 getChunk(Vec2 pos) const;
+  Rectangle getChunkBounds(Vec2 chunk) const;
+  map<Vec2, int> getDistances(Vec2 from, Rectangle area) const;
+  vector<Vec2> getPortals(Vec2 chunk) const;
+  vector<Vec2> getCrossings(Vec2 portal) const;
+  vector<pair<Vec2, Vec2>> findPortals(Vec2 chunk, Vec2 dir) const;
+  void updateChunk(Vec2 chunk);
+  void update();
+
+  Rectangle bounds;
+  function<bool(Vec2)> passableFun;
+  Sectors sectors;
+  Rectangle chunkBounds;
+  /** Pairs of neighboring squares connecting the chunk with the one to the right or below it.*/
+  Table<vector<pair<Vec2, Vec2>>> rightPortals;
+  Table<vector<pair<Vec2, Vec2>>> bottomPortals;
+  /** Distances between the portals of each chunk, walking only inside it.*/
+  Table<map<Vec2, vector<pair<Vec2, int>>>> edges;
+  Table<bool> dirtyRight;
+  Table<bool> dirtyBottom;
+  Table<bool> dirtyChunk;
+  bool dirty = true;
+};
+
+#endif
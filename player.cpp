@@ -90,6 +90,13 @@ void Player::onAlarmEvent(const Level* l, Vec2 pos) {
   }
 }
 
+void Player::onVisibilityChangedEvent(const Level* l, Rectangle area) {
+  Creature* c = getCreature();
+  int range = FieldOfView::sightRange;
+  if (l == c->getLevel() && c->getPosition().inRectangle(area.minusMargin(-range)))
+    l->markChanged(Rectangle(c->getPosition() - Vec2(range, range), c->getPosition() + Vec2(range + 1, range + 1)));
+}
+
 ControllerFactory Player::getFactory(Model *m, map<UniqueEntity<Level>::Id, MapMemory>* levelMemory) {
   return ControllerFactory([=](Creature* c) { return new Player(c, m, true, levelMemory);});
 }
@@ -380,6 +387,7 @@ void Player::equipmentAction() {
         itemsChoice.push_back(nullptr);
       }
     }
+    markVisionChanges();
     model->getView()->updateView(this);
     Optional<int> newIndex = model->getView()->chooseFromList("Equipment", list, index, View::NORMAL_MENU, nullptr,
         UserInputId::EQUIPMENT);
@@ -484,6 +492,7 @@ bool Player::interruptedByEnemy() {
   if (enemies.size() > 0) {
     for (const Creature* c : enemies)
       if (!contains(ignoreCreatures, c->getName().a())) {
+        markVisionChanges();
         model->getView()->updateView(this);
         privateMessage("You notice " + c->getName().a());
         return true;
@@ -509,7 +518,7 @@ void Player::travelAction() {
   vector<Vec2> squareDirs = getCreature()->getSquare()->getTravelDir();
   if (squareDirs.size() != 2) {
     travelling = false;
-    Debug() << "Stopped by multiple routes";
+    LOG(INFO, CREATURE) << "Stopped by multiple routes";
     return;
   }
   Optional<int> myIndex = findElement(squareDirs, -travelDir);
@@ -545,7 +554,7 @@ void Player::payDebtAction() {
           getCreature()->give(c, gold);
         }
       } else {
-        Debug() << "No debt " << c->getName().bare();
+        LOG(INFO, CREATURE) << "No debt " << c->getName().bare();
       }
     }
 }
@@ -597,9 +606,9 @@ void Player::sleeping() {
     ViewObject::setHallu(true);
   else
     ViewObject::setHallu(false);
-  MEASURE(
-      model->getView()->updateView(this),
-      "level render time");
+  markVisionChanges();
+  PROFILE_ZONE("level render");
+  model->getView()->updateView(this);
 }
 
 static bool displayTravelInfo = true;
@@ -632,9 +641,9 @@ void Player::makeMove() {
     ViewObject::setHallu(false);
   if (updateView) {
     updateView = false;
-    MEASURE(
-        model->getView()->updateView(this),
-        "level render time");
+    markVisionChanges();
+    PROFILE_ZONE("level render");
+    model->getView()->updateView(this);
   }
   if (displayTravelInfo && getCreature()->getSquare()->getName() == "road" 
       && model->getOptions()->getBoolValue(OptionId::HINTS)) {
@@ -647,6 +656,7 @@ void Player::makeMove() {
 /*    model->getView()->presentText("", "Every settlement that you find has a leader, and they may have quests for you."
         "\n \nYou can turn these messages off in the options (press F2).");*/
     displayGreeting = false;
+    markVisionChanges();
     model->getView()->updateView(this);
   }
   for (const Creature* c : getCreature()->getVisibleEnemies()) {
@@ -661,7 +671,7 @@ void Player::makeMove() {
     targetAction();
   else {
     UserInput action = model->getView()->getAction();
-    Debug() << "Action " << int(action.getId());
+    LOG(INFO, CREATURE) << "Action " << int(action.getId());
   vector<Vec2> direction;
   bool travel = false;
   if (action.getId() != UserInputId::IDLE) {
@@ -866,6 +876,22 @@ Optional<CreatureView::MovementInfo> Player::getMovementInfo() const {
     return Nothing();
 }
 
+void Player::markVisionChanges() {
+  Creature* c = getCreature();
+  VisionInfo current {c->getLevel(), c->getPosition(), c->getVision(), c->isBlind()};
+  int range = FieldOfView::sightRange;
+  if (!lastVision)
+    current.level->markChanged(current.level->getBounds());
+  else if (lastVision->level != current.level || lastVision->pos != current.pos
+      || lastVision->vision != current.vision || lastVision->blind != current.blind) {
+    lastVision->level->markChanged(Rectangle(lastVision->pos - Vec2(range, range),
+          lastVision->pos + Vec2(range + 1, range + 1)));
+    current.level->markChanged(Rectangle(current.pos - Vec2(range, range),
+          current.pos + Vec2(range + 1, range + 1)));
+  }
+  lastVision = current;
+}
+
 void Player::getViewIndex(Vec2 pos, ViewIndex& index) const {
   const Square* square = getLevel()->getSafeSquare(pos);
   if (getCreature()->canSee(pos))
@@ -873,7 +899,7 @@ void Player::getViewIndex(Vec2 pos, ViewIndex& index) const {
   else
     index.setHiddenId(square->getViewObject().id());
   if (!getCreature()->canSee(pos) && getMemory().hasViewIndex(pos))
-    index.mergeFromMemory(getMemory().getViewIndex(pos));
+    getMemory().mergeInto(pos, index);
   if (const Creature* c = square->getCreature()) {
     if (getCreature()->canSee(c) || c == getCreature())
       index.insert(c->getViewObject());
@@ -27,6 +27,7 @@
 class View;
 class Model;
 class Creature;
+class Vision;
 
 class Player : public Controller, public CreatureView {
   public:
@@ -82,6 +83,7 @@ class Player : public Controller, public CreatureView {
   REGISTER_HANDLER(ThrowEvent, const Level*, const Creature*, const Item*, const vector<Vec2>& trajectory);
   REGISTER_HANDLER(ExplosionEvent, const Level*, Vec2);
   REGISTER_HANDLER(AlarmEvent, const Level*, Vec2);
+  REGISTER_HANDLER(VisibilityChangedEvent, const Level*, Rectangle area);
   REGISTER_HANDLER(WorshipEvent, Creature* who, const Deity* to, WorshipType);
 
   void tryToPerform(CreatureAction);
@@ -128,6 +130,15 @@ class Player : public Controller, public CreatureView {
   };
   TimePosInfo currentTimePos = {Vec2(-1, -1), 0.0};
   TimePosInfo previousTimePos = {Vec2(-1, -1), 0.0};
+  /** Where and how the player was looking at the last view update.*/
+  struct VisionInfo {
+    const Level* level;
+    Vec2 pos;
+    Vision* vision;
+    bool blind;
+  };
+  Optional<VisionInfo> lastVision;
+  void markVisionChanges();
 };
 
 #endif
@@ -54,7 +54,8 @@ void PlayerControl::serialize(Archive& ar, const unsigned int version) {
     & SVAR(hints)
     & SVAR(visibleEnemies)
     & SVAR(visibleFriends)
-    & SVAR(notifiedConquered);
+    & SVAR(notifiedConquered)
+    & SVAR(visibilityMap);
   CHECK_SERIAL;
 }
 
@@ -208,7 +209,7 @@ static vector<string> getHints() {
 }
 
 PlayerControl::PlayerControl(Collective* col, Model* m, Level* level) : CollectiveControl(col), model(m),
-    hints(getHints()) {
+    hints(getHints()), visibilityMap(level->getBounds()) {
   bool hotkeys[128] = {0};
   for (BuildInfo info : getBuildInfo(level, nullptr)) {
     if (info.hotkey) {
@@ -851,6 +852,8 @@ void PlayerControl::refreshGameInfo(GameInfo& gameInfo) const {
   info.techButtons.clear();
   for (TechInfo tech : getTechInfo())
     info.techButtons.push_back(tech.button);
+  info.updateHashes();
+  gameInfo.villageInfo.updateHash();
   gameInfo.messageBuffer = messages;
 }
 
@@ -873,11 +876,30 @@ void PlayerControl::addImportantLongMessage(const string& msg, Optional<Vec2> po
 }
 
 void PlayerControl::update(Creature* c) {
-  if (contains(getCollective()->getCreatures(), c))
-    for (Vec2 pos : getCollective()->getLevel()->getVisibleTiles(c)) {
+  if (contains(getCollective()->getCreatures(), c)) {
+    vector<Vec2> visibleTiles = getCollective()->getLevel()->getVisibleTiles(c);
+    for (Vec2 pos : visibleTiles) {
       getCollective()->addKnownTile(pos);
       addToMemory(pos);
     }
+    if (c->getLevel() == getLevel()) {
+      visibleTiles.push_back(c->getPosition());
+      visibilityMap.update(c, visibleTiles);
+    } else
+      visibilityMap.remove(c);
+  } else
+    visibilityMap.remove(c);
+  markVisibilityChanges();
+}
+
+void PlayerControl::markVisibilityChanges() {
+  for (Vec2 pos : visibilityMap.popChangedTiles())
+    getLevel()->markChanged(pos);
+}
+
+void PlayerControl::markSelectionChanged() {
+  if (rectSelection)
+    getLevel()->markChanged(Rectangle::boundingBox({rectSelection->corner1, rectSelection->corner2}));
 }
 
 const MapMemory& PlayerControl::getMemory() const {
@@ -936,7 +958,7 @@ void PlayerControl::getViewIndex(Vec2 pos, ViewIndex& index) const {
   bool canSeePos = canSee(pos);
   getSquareViewIndex(square, canSeePos, index);
   if (!canSeePos && getMemory().hasViewIndex(pos))
-    index.mergeFromMemory(getMemory().getViewIndex(pos));
+    getMemory().mergeInto(pos, index);
   if (getCollective()->getAllSquares().count(pos) 
       && index.hasObject(ViewLayer::FLOOR_BACKGROUND)
       && index.getObject(ViewLayer::FLOOR_BACKGROUND).id() == ViewId::FLOOR)
@@ -1172,16 +1194,20 @@ void PlayerControl::processInput(View* view, UserInput input) {
         break;
         }
     case UserInputId::RECT_SELECTION:
+        markSelectionChanged();
         if (rectSelection) {
           rectSelection->corner2 = input.get<Vec2>();
         } else
           rectSelection = CONSTRUCT(SelectionInfo, c.corner1 = c.corner2 = input.get<Vec2>(););
+        markSelectionChanged();
         break;
     case UserInputId::RECT_DESELECTION:
+        markSelectionChanged();
         if (rectSelection) {
           rectSelection->corner2 = input.get<Vec2>();
         } else
           rectSelection = CONSTRUCT(SelectionInfo, c.corner1 = c.corner2 = input.get<Vec2>(); c.deselect = true;);
+        markSelectionChanged();
         break;
     case UserInputId::BUILD:
         handleSelection(input.get<BuildingInfo>().pos(),
@@ -1196,6 +1222,7 @@ void PlayerControl::processInput(View* view, UserInput input) {
           for (Vec2 v : Rectangle::boundingBox({rectSelection->corner1, rectSelection->corner2}))
             handleSelection(v, getBuildInfo()[input.get<BuildingInfo>().building()], true, rectSelection->deselect);
         }
+        markSelectionChanged();
         rectSelection = Nothing();
         selection = NONE;
         break;
@@ -1494,15 +1521,33 @@ bool PlayerControl::canSee(const Creature* c) const {
 }
 
 bool PlayerControl::canSee(Vec2 position) const {
-  if (seeEverything)
-    return true;
+  return seeEverything || visibilityMap.isVisible(position);
+}
+
+void PlayerControl::updateEyeball(Vec2 pos) {
+  if (getCollective()->getSquares(SquareId::EYEBALL).count(pos))
+    visibilityMap.updateEyeball(pos, getLevel()->getVisibleTiles(pos, Vision::get(VisionId::NORMAL)));
+  else
+    visibilityMap.removeEyeball(pos);
+}
+
+void PlayerControl::onVisibilityChangedEvent(const Level* l, Rectangle area) {
+  if (l != getLevel())
+    return;
+  // Only the minions and eyeballs that are within sight range of the area can see it.
+  Rectangle viewers = area.minusMargin(-FieldOfView::sightRange);
   for (Creature* c : getCollective()->getCreatures())
-    if (c->canSee(position) || c->getPosition() == position)
-      return true;
-  for (Vec2 pos : getCollective()->getSquares(SquareId::EYEBALL))
-    if (getLevel()->canSee(pos, position, Vision::get(VisionId::NORMAL)))
-      return true;
-  return false;
+    if (c->getLevel() == l && c->getPosition().inRectangle(viewers))
+      update(c);
+  for (Vec2 pos : visibilityMap.getEyeballs())
+    if (pos.inRectangle(viewers))
+      updateEyeball(pos);
+  markVisibilityChanges();
+}
+
+void PlayerControl::onVisionChangedEvent(const Creature* c) {
+  if (contains(getCollective()->getCreatures(), c))
+    update(const_cast<Creature*>(c));
 }
 
 const Tribe* PlayerControl::getTribe() const {
@@ -1574,6 +1619,8 @@ void PlayerControl::onConqueredLand(const string& name) {
 }
 
 void PlayerControl::onCreatureKilled(const Creature* victim, const Creature* killer) {
+  visibilityMap.remove(victim);
+  markVisibilityChanges();
   if (!getKeeper() && !retired) {
     model->gameOver(victim, getCollective()->getKills().size(), "enemies",
         getCollective()->getDangerLevel() + getCollective()->getPoints());
@@ -1662,18 +1709,21 @@ void PlayerControl::updateSquareMemory(Vec2 pos) {
 
 void PlayerControl::onConstructed(Vec2 pos, SquareType type) {
   updateSquareMemory(pos);
+  updateEyeball(pos);
+  markVisibilityChanges();
 }
 
 void PlayerControl::updateVisibleCreatures(Rectangle range) {
   visibleEnemies.clear();
   visibleFriends.clear();
-  for (const Creature* c : getLevel()->getAllCreatures(range)) 
-    if (canSee(c)) {
-      if (isEnemy(c))
-        visibleEnemies.push_back(c);
-      else if (c->getTribe() == getTribe())
-        visibleFriends.push_back(c);
-    }
+  getLevel()->forEachCreature(range, [this] (const Creature* c) {
+      if (canSee(c)) {
+        if (isEnemy(c))
+          visibleEnemies.push_back(c);
+        else if (c->getTribe() == getTribe())
+          visibleFriends.push_back(c);
+      }
+  });
 }
 
 vector<const Creature*> PlayerControl::getVisibleEnemies() const {
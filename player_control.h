@@ -25,6 +25,7 @@
 #include "collective_control.h"
 #include "collective.h"
 #include "event.h"
+#include "visibility_map.h"
 
 class Model;
 class Technology;
@@ -95,6 +96,8 @@ class PlayerControl : public CreatureView, public CollectiveControl {
   REGISTER_HANDLER(WorshipCreatureEvent, Creature* who, const Creature* to, WorshipType);
   REGISTER_HANDLER(SunlightChangeEvent);
   REGISTER_HANDLER(PickupEvent, const Creature* c, const vector<Item*>& items);
+  REGISTER_HANDLER(VisibilityChangedEvent, const Level*, Rectangle area);
+  REGISTER_HANDLER(VisionChangedEvent, const Creature*);
 
   friend class KeeperControlOverride;
 
@@ -110,6 +113,7 @@ class PlayerControl : public CreatureView, public CollectiveControl {
   void addDeityServant(Deity*, Vec2 deityPos, Vec2 victimPos);
   static string getWarningText(Collective::Warning);
   void updateSquareMemory(Vec2);
+  void updateEyeball(Vec2);
   bool isEnemy(const Creature*) const;
 
   Creature* getConsumptionTarget(View*, Creature* consumer);
@@ -207,6 +211,8 @@ class PlayerControl : public CreatureView, public CollectiveControl {
   static ViewObject getTrapObject(TrapType, bool built);
   bool underAttack() const;
   void addToMemory(Vec2 pos);
+  void markVisibilityChanges();
+  void markSelectionChanged();
   void getSquareViewIndex(const Square*, bool canSee, ViewIndex&) const;
   bool tryLockingDoor(Vec2 pos);
   void uncoverRandomLocation();
@@ -251,6 +257,7 @@ class PlayerControl : public CreatureView, public CollectiveControl {
   vector<const Creature*> SERIAL(visibleEnemies);
   vector<const Creature*> SERIAL(visibleFriends);
   unordered_set<const Collective*> SERIAL(notifiedConquered);
+  VisibilityMap SERIAL(visibilityMap);
   bool newTeam = false;
 };
 
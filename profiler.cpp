@@ -0,0 +1,148 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+
+#include "stdafx.h"
+
+#include "profiler.h"
+#include "util.h"
+
+namespace {
+
+struct ZoneEvent {
+  const char* name;
+  long long begin;
+  long long end;
+};
+
+/** Fixed size buffer of finished zones. Once full, the oldest events are overwritten. The owning thread
+    writes it under its mutex, which is only contended while dump() copies the events out.*/
+struct ThreadBuffer {
+  static const int size = 1 << 16;
+  ThreadBuffer(int id) : threadId(id), events(size) {}
+  int threadId;
+  std::mutex mutex;
+  vector<ZoneEvent> events;
+  long long numEvents = 0;
+
+  void add(const ZoneEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    events[numEvents % events.size()] = event;
+    ++numEvents;
+  }
+
+  /** Returns the recorded events, oldest first.*/
+  vector<ZoneEvent> getEvents() {
+    std::lock_guard<std::mutex> lock(mutex);
+    vector<ZoneEvent> ret;
+    for (long long i = max(0LL, numEvents - (long long) events.size()); i < numEvents; ++i)
+      ret.push_back(events[i % events.size()]);
+    return ret;
+  }
+};
+
+atomic<bool> enabled(false);
+std::mutex buffersMutex;
+vector<unique_ptr<ThreadBuffer>> buffers;
+
+/** Shrinks the thread's buffer to the events it recorded when the thread exits, so that finished threads
+    don't hold on to the whole ring buffer.*/
+struct BufferOwner {
+  ThreadBuffer* buffer = nullptr;
+
+  ~BufferOwner() {
+    if (!buffer)
+      return;
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    vector<ZoneEvent> events = buffer->getEvents();
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    buffer->numEvents = events.size();
+    buffer->events = std::move(events);
+  }
+};
+
+ThreadBuffer& getThreadBuffer() {
+  static thread_local BufferOwner owner;
+  if (!owner.buffer) {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffers.emplace_back(new ThreadBuffer(buffers.size()));
+    owner.buffer = buffers.back().get();
+  }
+  return *owner.buffer;
+}
+
+}
+
+long long Profiler::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::enable() {
+  enabled = true;
+}
+
+bool Profiler::isEnabled() {
+  return enabled;
+}
+
+Profiler::Zone::Zone(const char* n) : name(n), begin(enabled ? now() : -1) {
+}
+
+Profiler::Zone::~Zone() {
+  if (begin < 0)
+    return;
+  getThreadBuffer().add({name, begin, now()});
+}
+
+static string escapeJson(const char* s) {
+  string ret;
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\')
+      ret += '\\';
+    ret += *s;
+  }
+  return ret;
+}
+
+void Profiler::dump(const string& path) {
+  ofstream out(path);
+  CHECK(!!out) << "Couldn't open " << path;
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  vector<pair<int, vector<ZoneEvent>>> threads;
+  for (auto& buffer : buffers)
+    threads.emplace_back(buffer->threadId, buffer->getEvents());
+  long long start = -1;
+  for (auto& thread : threads)
+    for (const ZoneEvent& event : thread.second)
+      if (start < 0 || event.begin < start)
+        start = event.begin;
+  // Timestamps are in microseconds, keep the fraction even in long sessions.
+  out.setf(std::ios::fixed);
+  out.precision(3);
+  out << "{\"traceEvents\":[";
+  bool first = true;
+  for (auto& thread : threads)
+    for (const ZoneEvent& event : thread.second) {
+      if (!first)
+        out << ",\n";
+      first = false;
+      out << "{\"name\":\"" << escapeJson(event.name) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread.first
+          << ",\"ts\":" << double(event.begin - start) / 1000 << ",\"dur\":" << double(event.end - event.begin) / 1000
+          << "}";
+    }
+  out << "]}" << endl;
+  LOG(INFO, GENERAL) << "Profile written to " << path;
+}
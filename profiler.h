@@ -0,0 +1,62 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <string>
+
+/** Records nested timed zones into per-thread ring buffers, so that a whole session can be viewed
+    as a trace in chrome://tracing. A zone costs two clock reads and a store under the thread's own
+    uncontended lock, and nothing at all until the profiler is enabled. Compile with -DNO_PROFILER
+    to remove the zones altogether.*/
+class Profiler {
+  public:
+  /** Starts recording zones on all threads.*/
+  static void enable();
+  static bool isEnabled();
+
+  /** Writes everything still held in the ring buffers as Chrome trace event JSON.*/
+  static void dump(const string& path);
+
+  /** Times the enclosing scope. The name must outlive the profiler, use string literals.*/
+  class Zone {
+    public:
+    Zone(const char* name);
+    ~Zone();
+
+    private:
+    const char* name;
+    long long begin;
+  };
+
+  private:
+  static long long now();
+};
+
+#ifndef NO_PROFILER
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_ZONE(name) Profiler::Zone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+#else
+
+#define PROFILE_ZONE(name)
+
+#endif
+
+#endif
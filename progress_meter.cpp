@@ -7,7 +7,7 @@ ProgressMeter::ProgressMeter(double inc) : progress(0), increase(inc) {
 
 double ProgressMeter::getProgress() const {
   int p = progress;
-  Debug() << "Progress " << p;
+  LOG(INFO, GENERAL) << "Progress " << p;
   return min(1.0, progress * increase);
 }
 
@@ -15,3 +15,6 @@ void ProgressMeter::addProgress() {
   ++progress;
 }
 
+void ProgressMeter::reset() {
+  progress = 0;
+}
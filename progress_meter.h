@@ -21,6 +21,8 @@ class ProgressMeter {
   ProgressMeter(double increase);
   double getProgress() const;
   void addProgress();
+  /** Starts again from zero, used when world generation is retried.*/
+  void reset();
 
   private:
   atomic<int> progress;
@@ -10,11 +10,12 @@ class Renderable {
 
   SERIALIZATION_DECL(Renderable);
 
-  ~Renderable();
+  virtual ~Renderable();
 
   protected:
-  ViewObject& modViewObject();
-  void setViewObject(const ViewObject&);
+  /** Virtual, so that a subclass can track when its object changes.*/
+  virtual ViewObject& modViewObject();
+  virtual void setViewObject(const ViewObject&);
 
   private:
   PViewObject SERIAL(viewObject);
@@ -63,8 +63,7 @@ void Renderer::drawText(FontId id, int size, Color color, int x, int y, String s
   }
   t.setPosition(x + ox, y + oy);
   t.setColor(color);
-  renderList.push_back(
-      [this, t] { display->draw(t); });
+  addRenderElem([this, t] { display->draw(t); });
 }
 
 String Renderer::toUnicode(const string& s) {
@@ -101,13 +100,9 @@ void Renderer::drawImage(Rectangle r, const Texture& image, double scale) {
 }
 
 void Renderer::drawImage(int px, int py, int kx, int ky, const Texture& t, double scale) {
-  Sprite s(t, sf::IntRect(0, 0, (kx - px) / scale, (ky - py) / scale));
-  s.setPosition(px, py);
-  if (scale != 1) {
-    s.setScale(scale, scale);
-  }
-  renderList.push_back(
-      [this, s] { display->draw(s); });
+  int w = (kx - px) / scale;
+  int h = (ky - py) / scale;
+  addQuad(&t, sf::FloatRect(px, py, w * scale, h * scale), sf::FloatRect(0, 0, w, h), Color(255, 255, 255));
 }
 
 void Renderer::drawSprite(Vec2 pos, Vec2 spos, Vec2 size, const Texture& t, Optional<Color> color,
@@ -124,26 +119,24 @@ void Renderer::drawSprite(Vec2 pos, Vec2 stretchSize, const Texture& t) {
 
 void Renderer::drawSprite(int x, int y, int px, int py, int w, int h, const Texture& t, int dw, int dh,
     Optional<Color> color) {
-  Sprite s(t, sf::IntRect(px, py, w, h));
-  s.setPosition(x, y);
-  if (color)
-    s.setColor(*color);
-  if (dw != -1)
-    s.setScale(double(dw) / w, double(dh) / h);
-  renderList.push_back(
-      [this, s] { display->draw(s); });
+  if (dw == -1) {
+    dw = w;
+    dh = h;
+  }
+  addQuad(&t, sf::FloatRect(x, y, dw, dh), sf::FloatRect(px, py, w, h), color ? *color : Color(255, 255, 255));
 }
 
 void Renderer::drawFilledRectangle(const Rectangle& t, Color color, Optional<Color> outline) {
+  if (!outline) {
+    addQuad(nullptr, sf::FloatRect(t.getPX(), t.getPY(), t.getW(), t.getH()), sf::FloatRect(), color);
+    return;
+  }
   RectangleShape r(Vector2f(t.getW(), t.getH()));
   r.setPosition(t.getPX(), t.getPY());
   r.setFillColor(color);
-  if (outline) {
-    r.setOutlineThickness(-2);
-    r.setOutlineColor(*outline);
-  }
-  renderList.push_back(
-      [this, r] { display->draw(r); });
+  r.setOutlineThickness(-2);
+  r.setOutlineColor(*outline);
+  addRenderElem([this, r] { display->draw(r); });
 }
 
 void Renderer::drawFilledRectangle(int px, int py, int kx, int ky, Color color, Optional<Color> outline) {
@@ -251,7 +244,7 @@ bool Renderer::loadTilesFromDir(const string& path, Vec2 size) {
   vector<string> files;
   while (dirent* ent = readdir(dir)) {
     string name(ent->d_name);
-    Debug() << "Found " << name;
+    LOG(INFO, GUI) << "Found " << name;
     if (endsWith(name, imageSuf))
       files.push_back(name);
   }
@@ -289,10 +282,46 @@ bool Renderer::loadTilesFromFile(const string& path, Vec2 size) {
   return tiles.back().loadFromFile(path.c_str());
 }
 
+void Renderer::addRenderElem(function<void()> elem) {
+  flushQuads();
+  renderList.push_back(elem);
+}
+
+void Renderer::addQuad(const Texture* texture, sf::FloatRect dest, sf::FloatRect source, Color color) {
+  if (quadsBegin > -1 && texture != quadsTexture)
+    flushQuads();
+  if (quadsBegin == -1) {
+    quadsTexture = texture;
+    quadsBegin = quads.size();
+  }
+  float kx = dest.left + dest.width;
+  float ky = dest.top + dest.height;
+  float tkx = source.left + source.width;
+  float tky = source.top + source.height;
+  quads.emplace_back(Vector2f(dest.left, dest.top), color, Vector2f(source.left, source.top));
+  quads.emplace_back(Vector2f(kx, dest.top), color, Vector2f(tkx, source.top));
+  quads.emplace_back(Vector2f(kx, ky), color, Vector2f(tkx, tky));
+  quads.emplace_back(Vector2f(dest.left, ky), color, Vector2f(source.left, tky));
+}
+
+void Renderer::flushQuads() {
+  if (quadsBegin > -1) {
+    const Texture* texture = quadsTexture;
+    int begin = quadsBegin;
+    int end = quads.size();
+    renderList.push_back([this, texture, begin, end] {
+        display->draw(&quads[begin], end - begin, sf::Quads, RenderStates(texture)); });
+    quadsBegin = -1;
+  }
+}
+
 void Renderer::drawAndClearBuffer() {
+  PROFILE_ZONE("draw buffer");
+  flushQuads();
   for (auto& elem : renderList)
     elem();
   renderList.clear();
+  quads.clear();
   display->display();
   display->clear(Color(0, 0, 0));
 }
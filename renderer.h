@@ -151,6 +151,14 @@ class Renderer {
   deque<Event> eventQueue;
   bool genReleaseEvent = false;
   vector<function<void()>> renderList;
+  void addRenderElem(function<void()>);
+  /** Sprites and plain rectangles are gathered into runs of quads sharing a texture, and each run
+      is drawn with a single call. Other elements end the current run, so the drawing order is kept.*/
+  void addQuad(const Texture*, sf::FloatRect dest, sf::FloatRect source, Color);
+  void flushQuads();
+  vector<sf::Vertex> quads;
+  const Texture* quadsTexture = nullptr;
+  int quadsBegin = -1;
 };
 
 #endif
@@ -20,7 +20,8 @@ template <class Archive>
 void Sectors::serialize(Archive& ar, const unsigned int version) {
   ar& SVAR(bounds)
     & SVAR(sectors)
-    & SVAR(sizes);
+    & SVAR(sizes)
+    & SVAR(freeSectors);
   CHECK_SERIAL;
 }
 
@@ -57,13 +58,19 @@ void Sectors::add(Vec2 pos) {
 
 void Sectors::setSector(Vec2 pos, int sector) {
   CHECK(sectors[pos] != sector);
-  if (sectors[pos] > -1)
-    --sizes[sectors[pos]];
+  if (sectors[pos] > -1 && --sizes[sectors[pos]] == 0)
+    freeSectors.push_back(sectors[pos]);
   sectors[pos] = sector;
-  ++sizes[sector];
+  if (sector > -1)
+    ++sizes[sector];
 }
 
 int Sectors::getNewSector() {
+  if (!freeSectors.empty()) {
+    int ret = freeSectors.back();
+    freeSectors.pop_back();
+    return ret;
+  }
   sizes.push_back(0);
   return sizes.size() - 1;
 }
@@ -86,17 +93,96 @@ void Sectors::join(Vec2 pos1, int sector) {
 void Sectors::remove(Vec2 pos) {
   if (sectors[pos] == -1)
     return;
-  int curNumber = sizes[sectors[pos]];
-  --sizes[sectors[pos]];
-  sectors[pos] = -1;
-  int maxSector = sizes.size() - 1;
-  vector<int> newSizes;
+  setSector(pos, -1);
+  vector<Vec2> starts = getDisconnectedNeighbors(pos);
+  if (starts.size() > 1)
+    split(starts);
+}
+
+vector<Vec2> Sectors::getDisconnectedNeighbors(Vec2 pos) const {
+  vector<Vec2> neighbors;
   for (Vec2 v : pos.neighbors8())
-    if (v.inRectangle(bounds) && sectors[v] > -1 && sectors[v] <= maxSector) {
-      join(v, getNewSector());
-      newSizes.push_back(sizes[sectors[v]]);
+    if (v.inRectangle(bounds) && sectors[v] > -1)
+      neighbors.push_back(v);
+  vector<int> group(neighbors.size());
+  for (int i : All(neighbors)) {
+    group[i] = i;
+    for (int j : Range(i))
+      if ((neighbors[i] - neighbors[j]).length8() == 1) {
+        int old = group[i];
+        for (int& g : group)
+          if (g == old)
+            g = group[j];
+      }
+  }
+  vector<Vec2> ret;
+  for (int i : All(neighbors))
+    if (group[i] == i)
+      ret.push_back(neighbors[i]);
+  return ret;
+}
+
+void Sectors::split(const vector<Vec2>& starts) {
+  // The searches advance one square at a time each. A search that runs out of squares before meeting
+  // any other has found a separate component, so at most the smaller parts get relabeled.
+  struct Search {
+    queue<Vec2> q;
+    vector<Vec2> visited;
+    int parent;
+  };
+  vector<Search> searches(starts.size());
+  unordered_map<Vec2, int> owner;
+  for (int i : All(starts)) {
+    searches[i].q.push(starts[i]);
+    searches[i].visited.push_back(starts[i]);
+    searches[i].parent = i;
+    owner[starts[i]] = i;
+  }
+  function<int(int)> find = [&](int i) {
+    return searches[i].parent == i ? i : searches[i].parent = find(searches[i].parent);
+  };
+  vector<int> newSizes;
+  int numActive = starts.size();
+  while (numActive > 1)
+    for (int i : All(searches)) {
+      if (searches[i].parent != i || searches[i].visited.empty() || numActive == 1)
+        continue;
+      if (searches[i].q.empty()) {
+        int sector = getNewSector();
+        for (Vec2 v : searches[i].visited)
+          setSector(v, sector);
+        newSizes.push_back(searches[i].visited.size());
+        searches[i].visited.clear();
+        --numActive;
+        continue;
+      }
+      Vec2 pos = searches[i].q.front();
+      searches[i].q.pop();
+      for (Vec2 v : pos.neighbors8())
+        if (v.inRectangle(bounds) && sectors[v] > -1) {
+          auto it = owner.find(v);
+          if (it == owner.end()) {
+            owner[v] = i;
+            searches[i].visited.push_back(v);
+            searches[i].q.push(v);
+          } else {
+            int other = find(it->second);
+            if (other != i) {
+              Search& target = searches[other];
+              // The current square goes back to the queue, so its remaining neighbors get explored.
+              target.q.push(pos);
+              for (; !searches[i].q.empty(); searches[i].q.pop())
+                target.q.push(searches[i].q.front());
+              append(target.visited, searches[i].visited);
+              searches[i].visited.clear();
+              searches[i].parent = other;
+              --numActive;
+              break;
+            }
+          }
+        }
     }
-  Debug() << "Sectors size " << curNumber << " split into " << newSizes;
+  LOG(INFO, PATH) << "Sector split off " << newSizes;
 }
 
 using namespace std;
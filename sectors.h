@@ -33,9 +33,12 @@ class Sectors {
   void setSector(Vec2, int);
   int getNewSector();
   void join(Vec2, int);
+  vector<Vec2> getDisconnectedNeighbors(Vec2) const;
+  void split(const vector<Vec2>& starts);
   Rectangle SERIAL(bounds);
   Table<int> SERIAL(sectors);
   vector<int> SERIAL(sizes);
+  vector<int> SERIAL(freeSectors);
 };
 
 #endif
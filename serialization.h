@@ -57,6 +57,10 @@ typedef portable_oarchive OutputArchive;
 #define SVAR(X) boost::serialization::make_nvp(#X, X)
 #endif
 
+/** Marks a member that is derived from serialized state. It's left out of the archive, so it starts empty
+    after loading and has to be rebuilt on first use. check_serial.sh fails if it's passed to SVAR.*/
+#define TRANSIENT(X) X
+
 #define SERIALIZATION_DECL(A) \
   friend boost::serialization::access; \
   A(); \
@@ -39,31 +39,162 @@ const int revShortestLimit = 15;
 
 class DistanceTable {
   public:
-  DistanceTable(Rectangle bounds) : ddist(bounds), dirty(bounds, 0) {} 
+  DistanceTable(Rectangle bounds) : ddist(bounds), queuePos(bounds), dirty(bounds, 0) {} 
 
   double getDistance(Vec2 v) const {
     return dirty[v] < counter ? ShortestPath::infinity : ddist[v];
   }
 
   void setDistance(Vec2 v, double d) {
+    if (dirty[v] < counter)
+      queuePos[v] = -1;
     ddist[v] = d;
     dirty[v] = counter;
   }
 
+  int getQueuePos(Vec2 v) const {
+    return dirty[v] < counter ? -1 : queuePos[v];
+  }
+
+  void setQueuePos(Vec2 v, int pos) {
+    CHECK(dirty[v] == counter);
+    queuePos[v] = pos;
+  }
+
   void clear() {
     ++counter;
   }
 
   private:
   Table<double> ddist;
+  Table<int> queuePos;
   Table<int> dirty;
   int counter = 1;
 };
 
-static DistanceTable distanceTable(Level::getMaxBounds());
+/** Binary min-heap of tiles that keeps every tile's position in the DistanceTable, so that
+  lowering a tile's priority updates its entry in place instead of pushing a duplicate.*/
+class TileQueue {
+  public:
+  TileQueue(DistanceTable& t) : table(t) {}
+
+  bool empty() const {
+    return heap.empty();
+  }
+
+  Vec2 top() const {
+    return heap[0].pos;
+  }
+
+  void pop() {
+    table.setQueuePos(heap[0].pos, -1);
+    if (heap.size() > 1) {
+      set(0, heap.back());
+      heap.pop_back();
+      siftDown(0);
+    } else
+      heap.pop_back();
+  }
+
+  /** Inserts the tile or updates its priority if it's already queued. The tile must have its distance set.*/
+  void push(Vec2 pos, double priority) {
+    int ind = table.getQueuePos(pos);
+    if (ind == -1) {
+      heap.push_back({pos, priority});
+      table.setQueuePos(pos, heap.size() - 1);
+      siftUp(heap.size() - 1);
+    } else if (priority < heap[ind].priority) {
+      heap[ind].priority = priority;
+      siftUp(ind);
+    } else {
+      heap[ind].priority = priority;
+      siftDown(ind);
+    }
+  }
+
+  void clear() {
+    for (const Elem& elem : heap)
+      table.setQueuePos(elem.pos, -1);
+    heap.clear();
+  }
+
+  private:
+  struct Elem {
+    Vec2 pos;
+    double priority;
+  };
+
+  void set(int ind, const Elem& elem) {
+    heap[ind] = elem;
+    table.setQueuePos(elem.pos, ind);
+  }
+
+  void siftUp(int ind) {
+    Elem elem = heap[ind];
+    while (ind > 0) {
+      int parent = (ind - 1) / 2;
+      if (heap[parent].priority <= elem.priority)
+        break;
+      set(ind, heap[parent]);
+      ind = parent;
+    }
+    set(ind, elem);
+  }
+
+  void siftDown(int ind) {
+    Elem elem = heap[ind];
+    int size = heap.size();
+    while (2 * ind + 1 < size) {
+      int child = 2 * ind + 1;
+      if (child + 1 < size && heap[child + 1].priority < heap[child].priority)
+        ++child;
+      if (elem.priority <= heap[child].priority)
+        break;
+      set(ind, heap[child]);
+      ind = child;
+    }
+    set(ind, elem);
+  }
+
+  vector<Elem> heap;
+  DistanceTable& table;
+};
+
+/** Scratch memory for a single search. Each thread gets its own, so searches can run concurrently.*/
+struct SearchState {
+  SearchState() : distanceTable(Level::getMaxBounds()), queue(distanceTable) {}
+
+  void clear() {
+    queue.clear();
+    distanceTable.clear();
+  }
+
+  DistanceTable distanceTable;
+  TileQueue queue;
+};
+
+static SearchState& getSearchState() {
+  static thread_local SearchState state;
+  return state;
+}
 
 const int margin = 15;
 
+/** Paths longer than this are first planned on the level's PathGraph.*/
+const int hierarchicalDistance = 2 * PathGraph::chunkSize;
+
+/** Picks the farthest waypoint that is still close enough to be refined with a local search.*/
+static Vec2 getRefinedWaypoint(const vector<Vec2>& waypoints, Vec2 from) {
+  CHECK(waypoints.size() >= 2);
+  Vec2 ret = waypoints[1];
+  for (int i : Range(2, waypoints.size()))
+    if (from.dist8(waypoints[i]) <= hierarchicalDistance)
+      ret = waypoints[i];
+    else
+      break;
+  return ret;
+}
+
 ShortestPath::ShortestPath(const Level* level, const Creature* creature, Vec2 to, Vec2 from, double mult)
     : target(to), directions(Vec2::directions8()), bounds(level->getBounds()) {
   auto entryFun = [=](Vec2 pos) { 
@@ -81,18 +212,50 @@ ShortestPath::ShortestPath(const Level* level, const Creature* creature, Vec2 to
   CHECK(to.inRectangle(level->getBounds()));
   CHECK(from.inRectangle(level->getBounds()));
   if (mult == 0) {
-    // Use a suboptimal, but faster pathfinding.
-    init(entryFun, [](Vec2 v)->double { return 2 * v.lengthD(); }, target, from);
+    initHierarchical(entryFun, from.dist8(to) > hierarchicalDistance
+        ? &level->getPathGraph(creature->getMovementType()) : nullptr, from);
   } else {
     auto lengthFun = [](Vec2 v)->double { return v.length8(); };
     bounds = bounds.intersection(Rectangle(min(to.x, from.x) - margin, min(to.y, from.y) - margin,
         max(to.x, from.x) + margin, max(to.y, from.y) + margin));
     init(entryFun, lengthFun, target, Nothing(), revShortestLimit);
-    distanceTable.setDistance(target, infinity);
+    getSearchState().distanceTable.setDistance(target, infinity);
     reverse(entryFun, lengthFun, mult, from, revShortestLimit);
   }
 }
 
+ShortestPath::ShortestPath(Rectangle a, function<double(Vec2)> entryFun, PathGraph& graph, Vec2 to, Vec2 from)
+    : target(to), directions(Vec2::directions8()), bounds(a) {
+  CHECK(Level::getMaxBounds().contains(a));
+  initHierarchical(entryFun, from.dist8(to) > hierarchicalDistance ? &graph : nullptr, from);
+}
+
+template <typename EntryFun>
+void ShortestPath::initHierarchical(EntryFun entryFun, PathGraph* graph, Vec2 from) {
+  // Use a suboptimal, but faster pathfinding.
+  auto lengthFun = [](Vec2 v)->double { return 2 * v.lengthD(); };
+  if (graph) {
+    if (!graph->isConnected(from, target)) {
+      LOG(TRACE, PATH) << "Shortest path from " << from << " to " << target << " rejected by sectors";
+      reversed = false;
+      return;
+    }
+    // Only the path to a nearby waypoint is computed, the rest is planned again once it's reached.
+    if (Optional<vector<Vec2>> waypoints = graph->getWaypoints(from, target)) {
+      Rectangle area = bounds;
+      Vec2 waypoint = getRefinedWaypoint(*waypoints, from);
+      bounds = bounds.intersection(Rectangle(min(waypoint.x, from.x) - margin,
+          min(waypoint.y, from.y) - margin, max(waypoint.x, from.x) + margin,
+          max(waypoint.y, from.y) + margin));
+      init(entryFun, lengthFun, waypoint, from);
+      if (!path.empty())
+        return;
+      bounds = area;
+    }
+  }
+  init(entryFun, lengthFun, target, from);
+}
+
 ShortestPath::ShortestPath(Rectangle a, function<double(Vec2)> entryFun, function<int(Vec2)> lengthFun,
     vector<Vec2> dir, Vec2 to, Vec2 from, double mult) : target(to), directions(dir), bounds(a) {
   CHECK(Level::getMaxBounds().contains(a));
@@ -100,70 +263,69 @@ ShortestPath::ShortestPath(Rectangle a, function<double(Vec2)> entryFun, functio
     init(entryFun, lengthFun, target, from);
   else {
     init(entryFun, lengthFun, target, Nothing(), revShortestLimit);
-    distanceTable.setDistance(target, infinity);
+    getSearchState().distanceTable.setDistance(target, infinity);
     reverse(entryFun, lengthFun, mult, from, revShortestLimit);
   }
 }
 
-void ShortestPath::init(function<double(Vec2)> entryFun, function<double(Vec2)> lengthFun, Vec2 target,
-    Optional<Vec2> from, Optional<int> limit) {
+template <typename EntryFun, typename LengthFun>
+void ShortestPath::init(EntryFun entryFun, LengthFun lengthFun, Vec2 target, Optional<Vec2> from,
+    Optional<int> limit) {
+  PROFILE_ZONE("shortest path");
   reversed = false;
-  distanceTable.clear();
-  function<bool(Vec2, Vec2)> comparator;
-  if (from)
-    comparator = [&](Vec2 pos1, Vec2 pos2) {
-      return distanceTable.getDistance(pos1) + lengthFun(*from - pos1) > 
-          distanceTable.getDistance(pos2) + lengthFun(*from - pos2); };
-  else
-    comparator = [this](Vec2 pos1, Vec2 pos2) {
-      return distanceTable.getDistance(pos1) > distanceTable.getDistance(pos2); };
-  priority_queue<Vec2, vector<Vec2>, decltype(comparator)> q(comparator) ;
+  SearchState& state = getSearchState();
+  state.clear();
+  DistanceTable& distanceTable = state.distanceTable;
+  TileQueue& q = state.queue;
+  auto priority = [&](Vec2 pos, double dist) {
+    return from ? dist + lengthFun(*from - pos) : dist; };
   distanceTable.setDistance(target, 0);
-  q.push(target);
+  q.push(target, priority(target, 0));
   int numPopped = 0;
   while (!q.empty()) {
     ++numPopped;
     Vec2 pos = q.top();
-   // Debug() << "Popping " << pos << " " << distance[pos]  << " " << (from ? (*from - pos).length4() : 0);
-    if (from == pos || (limit && distanceTable.getDistance(pos) >= *limit)) {
-      Debug() << "Shortest path from " << (from ? *from : Vec2(-1, -1)) << " to " << target << " " << numPopped
-        << " visited distance " << distanceTable.getDistance(pos);
-      constructPath(pos);
+   // LOG(TRACE, PATH) << "Popping " << pos << " " << distance[pos]  << " " << (from ? (*from - pos).length4() : 0);
+    double cdist = distanceTable.getDistance(pos);
+    if (from == pos || (limit && cdist >= *limit)) {
+      LOG(TRACE, PATH) << "Shortest path from " << (from ? *from : Vec2(-1, -1)) << " to " << target << " " << numPopped
+        << " visited distance " << cdist;
+      constructPath(pos, target);
       return;
     }
     q.pop();
     for (Vec2 dir : directions) {
       Vec2 next = pos + dir;
       if (next.inRectangle(bounds)) {
-        double cdist = distanceTable.getDistance(pos);
         double ndist = distanceTable.getDistance(next);
         if (cdist < ndist) {
           double dist = cdist + entryFun(next);
           CHECK(dist > cdist) << "Entry fun non positive " << dist - cdist;
           if (dist < ndist) {
             distanceTable.setDistance(next, dist);
-            q.push(next);
+            q.push(next, priority(next, dist));
           }
         }
       }
     }
   }
-  Debug() << "Shortest path exhausted, " << numPopped << " visited";
+  LOG(TRACE, PATH) << "Shortest path exhausted, " << numPopped << " visited";
 }
 
-void ShortestPath::reverse(function<double(Vec2)> entryFun, function<double(Vec2)> lengthFun, double mult, Vec2 from,
-    int limit) {
+template <typename EntryFun, typename LengthFun>
+void ShortestPath::reverse(EntryFun entryFun, LengthFun lengthFun, double mult, Vec2 from, int limit) {
   reversed = true;
-  function<bool(Vec2, Vec2)> comparator = [=](Vec2 pos1, Vec2 pos2) {
-    return distanceTable.getDistance(pos1) + lengthFun(from - pos1) 
-      > distanceTable.getDistance(pos2) + lengthFun(from - pos2); };
-
-  priority_queue<Vec2, vector<Vec2>, decltype(comparator)> q(comparator) ;
+  SearchState& state = getSearchState();
+  DistanceTable& distanceTable = state.distanceTable;
+  TileQueue& q = state.queue;
+  q.clear();
+  auto priority = [&](Vec2 pos, double dist) {
+    return dist + lengthFun(from - pos); };
   for (Vec2 v : bounds) {
     double dist = distanceTable.getDistance(v);
     if (dist <= limit) {
       distanceTable.setDistance(v, mult * dist);
-      q.push(v);
+      q.push(v, priority(v, mult * dist));
     }
   }
   int numPopped = 0;
@@ -171,26 +333,32 @@ void ShortestPath::reverse(function<double(Vec2)> entryFun, function<double(Vec2
     ++numPopped;
     Vec2 pos = q.top();
     if (from == pos) {
-      Debug() << "Rev shortest path from " << " from " << target << " " << numPopped << " visited";
-      constructPath(pos, true);
+      LOG(TRACE, PATH) << "Rev shortest path from " << " from " << target << " " << numPopped << " visited";
+      constructPath(pos, target, true);
       return;
     }
     q.pop();
+    double cdist = distanceTable.getDistance(pos);
     for (Vec2 dir : directions)
       if ((pos + dir).inRectangle(bounds)) {
-        if (distanceTable.getDistance(pos + dir) > distanceTable.getDistance(pos) + entryFun(pos + dir) && 
-            distanceTable.getDistance(pos + dir) < 0) {
-          distanceTable.setDistance(pos + dir, distanceTable.getDistance(pos) + entryFun(pos + dir));
-          q.push(pos + dir);
+        Vec2 next = pos + dir;
+        double ndist = distanceTable.getDistance(next);
+        if (ndist < 0) {
+          double dist = cdist + entryFun(next);
+          if (ndist > dist) {
+            distanceTable.setDistance(next, dist);
+            q.push(next, priority(next, dist));
+          }
         }
       }
   }
-  Debug() << "Rev shortest path from " << " from " << target << " " << numPopped << " visited";
+  LOG(TRACE, PATH) << "Rev shortest path from " << " from " << target << " " << numPopped << " visited";
 }
 
-void ShortestPath::constructPath(Vec2 pos, bool reversed) {
+void ShortestPath::constructPath(Vec2 pos, Vec2 end, bool reversed) {
+  const DistanceTable& distanceTable = getSearchState().distanceTable;
   vector<Vec2> ret;
-  while (pos != target) {
+  while (pos != end) {
     Vec2 next;
     double lowest = distanceTable.getDistance(pos);
     CHECK(lowest < infinity);
@@ -211,7 +379,7 @@ void ShortestPath::constructPath(Vec2 pos, bool reversed) {
     pos = next;
   }
   if (!reversed)
-    ret.push_back(target);
+    ret.push_back(end);
   path = vector<Vec2>(ret.rbegin(), ret.rend());
 }
 
@@ -234,14 +402,19 @@ Vec2 ShortestPath::getTarget() const {
   return target;
 }
 
+bool ShortestPath::reachedPartialEnd(Vec2 pos) const {
+  // The path is stored from its end, which is a waypoint if it's not the target.
+  return !reversed && !path.empty() && path[0] != target && path[0] == pos;
+}
+
 Dijkstra::Dijkstra(Rectangle bounds, Vec2 from, int maxDist, function<double(Vec2)> entryFun,
       vector<Vec2> directions) {
-  distanceTable.clear();
-  function<bool(Vec2, Vec2)> comparator = [&] (Vec2 pos1, Vec2 pos2) {
-    return distanceTable.getDistance(pos1) > distanceTable.getDistance(pos2); };
-  priority_queue<Vec2, vector<Vec2>, decltype(comparator)> q(comparator) ;
+  SearchState& state = getSearchState();
+  state.clear();
+  DistanceTable& distanceTable = state.distanceTable;
+  TileQueue& q = state.queue;
   distanceTable.setDistance(from, 0);
-  q.push(from);
+  q.push(from, 0);
   int numPopped = 0;
   while (!q.empty()) {
     ++numPopped;
@@ -260,7 +433,7 @@ Dijkstra::Dijkstra(Rectangle bounds, Vec2 from, int maxDist, function<double(Vec
           CHECK(dist > cdist) << "Entry fun non positive " << dist - cdist;
           if (dist < ndist) {
             distanceTable.setDistance(next, dist);
-            q.push(next);
+            q.push(next, dist);
           }
         }
       }
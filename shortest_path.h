@@ -22,6 +22,7 @@
 
 class Creature;
 class Level;
+class PathGraph;
 
 class ShortestPath {
   public:
@@ -34,20 +35,30 @@ class ShortestPath {
       Vec2 target,
       Vec2 from,
       double mult = 0);
+  /** Plans long paths on the graph first and only computes the way to the nearest waypoint, like the
+      constructor taking a level does with \paramname{mult} = 0.*/
+  ShortestPath(Rectangle area, function<double(Vec2)> entryFun, PathGraph&, Vec2 target, Vec2 from);
   bool isReachable(Vec2 pos) const;
   Vec2 getNextMove(Vec2 pos);
   Vec2 getTarget() const;
   bool isReversed() const;
+  /** Checks if the path only led to a waypoint on the way to the target, and \paramname{pos} is that
+      waypoint, so the rest of the way must be planned now.*/
+  bool reachedPartialEnd(Vec2 pos) const;
 
   static const double infinity;
 
   SERIALIZATION_DECL(ShortestPath);
 
   private:
-  void init(function<double(Vec2)> entryFun, function<double(Vec2)> lengthFun, Vec2 target, Optional<Vec2> from,
+  template <typename EntryFun, typename LengthFun>
+  void init(EntryFun entryFun, LengthFun lengthFun, Vec2 target, Optional<Vec2> from,
       Optional<int> limit = Nothing());
-  void reverse(function<double(Vec2)> entryFun, function<double(Vec2)> lengthFun, double mult, Vec2 from, int limit);
-  void constructPath(Vec2 start, bool reversed = false);
+  template <typename EntryFun>
+  void initHierarchical(EntryFun entryFun, PathGraph*, Vec2 from);
+  template <typename EntryFun, typename LengthFun>
+  void reverse(EntryFun entryFun, LengthFun lengthFun, double mult, Vec2 from, int limit);
+  void constructPath(Vec2 start, Vec2 end, bool reversed = false);
   vector<Vec2> SERIAL(path);
   Vec2 SERIAL(target);
   vector<Vec2> SERIAL(directions);
@@ -49,11 +49,11 @@ void Square::serialize(Archive& ar, const unsigned int version) {
     & SVAR(dirty)
     & SVAR(canDestroySquare);
   CHECK_SERIAL;
-  if (progressMeter)
-    progressMeter->addProgress();
+  if (ProgressMeter* meter = progressMeter)
+    meter->addProgress();
 }
 
-ProgressMeter* Square::progressMeter = nullptr;
+atomic<ProgressMeter*> Square::progressMeter(nullptr);
 
 SERIALIZABLE(Square);
 
@@ -88,7 +88,7 @@ string Square::getName() const {
 }
 
 void Square::setName(const string& s) {
-  dirty = true;
+  setDirty();
   name = s;
 }
 
@@ -126,7 +126,7 @@ bool Square::canConstruct(SquareType type) const {
 }
 
 bool Square::construct(SquareType type) {
-  dirty = true;
+  setDirty();
   CHECK(canConstruct(type));
   if (--constructions[type.getId()] <= 0) {
     PSquare newSquare = PSquare(SquareFactory::get(type));
@@ -142,7 +142,7 @@ bool Square::canDestroy() const {
 
 void Square::destroy() {
   CHECK(canDestroy());
-  dirty = true;
+  setDirty();
   getLevel()->globalMessage(getPosition(), "The " + getName() + " is destroyed.");
   GlobalEvents.addSquareReplacedEvent(getLevel(), getPosition());
   getLevel()->replaceSquare(getPosition(), PSquare(SquareFactory::get(SquareId::FLOOR)));
@@ -157,7 +157,7 @@ void Square::destroyBy(Creature* c) {
 }
 
 void Square::burnOut() {
-  dirty = true;
+  setDirty();
   getLevel()->globalMessage(getPosition(), "The " + getName() + " burns down.");
   GlobalEvents.addSquareReplacedEvent(getLevel(), getPosition());
   getLevel()->replaceSquare(getPosition(), PSquare(SquareFactory::get(SquareId::FLOOR)));
@@ -190,25 +190,34 @@ const Level* Square::getLevel() const {
 }
 
 void Square::setFog(double val) {
-  dirty = true;
+  setDirty();
   fog = val;
 }
 
 void Square::tick(double time) {
-  dirty = true;
-  if (!inventory.isEmpty())
+  if (!inventory.isEmpty()) {
+    // Items that rot change how the square looks.
+    Item* topItem = getTopItem();
+    ViewId topId = topItem->getViewObject().id();
     for (Item* item : inventory.getItems()) {
       item->tick(time, level, position);
       if (item->isDiscarded())
-        inventory.removeItem(item);
+        removeItem(item);
     }
+    if (getTopItem() == topItem && topItem->getViewObject().id() != topId)
+      setDirty();
+  }
+  double gasAmount = poisonGas.getAmount();
   poisonGas.tick(level, position);
+  if (poisonGas.getAmount() != gasAmount)
+    setDirty();
   if (creature && poisonGas.getAmount() > 0.2) {
     creature->poisonWithGas(min(1.0, poisonGas.getAmount()));
   }
   if (fire.isBurning()) {
-    modViewObject().setAttribute(ViewObject::Attribute::BURNING, fire.getSize());
-    Debug() << getName() << " burning " << fire.getSize();
+    if (getViewObject().getAttribute(ViewObject::Attribute::BURNING) != fire.getSize())
+      modViewObject().setAttribute(ViewObject::Attribute::BURNING, fire.getSize());
+    LOG(TRACE, LEVEL) << getName() << " burning " << fire.getSize();
     for (Square* s : level->getSquares(position.neighbors8(true)))
       if (fire.getSize() > Random.getDouble() * 40)
         s->setOnFire(fire.getSize() / 20);
@@ -253,7 +262,7 @@ bool Square::itemBounces(Item* item, Vision* v) const {
 }
 
 void Square::onItemLands(vector<PItem> item, const Attack& attack, int remainingDist, Vec2 dir, Vision* vision) {
-  dirty = true;
+  setDirty();
   if (creature) {
     item[0]->onHitCreature(creature, attack, item.size() > 1);
     if (!item[0]->isDiscarded())
@@ -296,9 +305,11 @@ bool Square::canEnterSpecial(const Creature* c) const {
 }
 
 void Square::setOnFire(double amount) {
-  dirty = true;
   bool burning = fire.isBurning();
+  double size = fire.getSize();
   fire.set(amount);
+  if (fire.getSize() != size)
+    setDirty();
   if (!burning && fire.isBurning()) {
     level->addTickingSquare(position);
     level->globalMessage(position, "The " + getName() + " catches fire.");
@@ -311,8 +322,8 @@ void Square::setOnFire(double amount) {
 }
 
 void Square::addPoisonGas(double amount) {
-  dirty = true;
   if (canSeeThru()) {
+    setDirty();
     poisonGas.addAmount(amount);
     level->addTickingSquare(position);
   }
@@ -331,7 +342,7 @@ Optional<ViewObject> Square::getBackgroundObject() const {
 }
 
 void Square::setBackground(const Square* square) {
-  dirty = true;
+  setDirty();
   if (getViewObject().layer() != ViewLayer::FLOOR_BACKGROUND) {
     const ViewObject& obj = square->backgroundObject ? (*square->backgroundObject) : square->getViewObject();
     if (obj.layer() == ViewLayer::FLOOR_BACKGROUND)
@@ -360,14 +371,14 @@ void Square::getViewIndex(ViewIndex& ret, const Tribe* tribe) const {
 }
 
 void Square::onEnter(Creature* c) {
-  dirty = true;
+  setDirty();
   for (Trigger* t : extractRefs(triggers))
     t->onCreatureEnter(c);
   onEnterSpecial(c);
 }
 
 void Square::dropItem(PItem item) {
-  dirty = true;
+  setDirty();
   if (level)  // if level == null, then it's being constructed, square will be added later
     level->addTickingSquare(getPosition());
   inventory.addItem(std::move(item));
@@ -387,7 +398,7 @@ Creature* Square::getCreature() {
 }
 
 void Square::addTrigger(PTrigger t) {
-  dirty = true;
+  setDirty();
   level->addTickingSquare(position);
   Trigger* ref = t.get();
   level->addLightSource(position, t->getLightEmission());
@@ -400,7 +411,7 @@ const vector<Trigger*> Square::getTriggers() const {
 
 PTrigger Square::removeTrigger(Trigger* trigger) {
   CHECK(trigger);
-  dirty = true;
+  setDirty();
   for (PTrigger& t : triggers)
     if (t.get() == trigger) {
       PTrigger ret = std::move(t);
@@ -424,7 +435,7 @@ const Creature* Square::getCreature() const {
 }
 
 void Square::removeCreature() {
-  dirty = true;
+  setDirty();
   CHECK(creature);
   creature = 0;
 }
@@ -460,16 +471,38 @@ vector<Item*> Square::getItems(function<bool (Item*)> predicate) const {
   return inventory.getItems(predicate);
 }
 
+const vector<Item*>& Square::getAllItems() const {
+  return inventory.getAllItems();
+}
+
 PItem Square::removeItem(Item* it) {
-  dirty = true;
+  setDirty();
   return inventory.removeItem(it);
 }
 
 vector<PItem> Square::removeItems(vector<Item*> it) {
-  dirty = true;
+  setDirty();
   return inventory.removeItems(it);
 }
 
+void Square::setDirty() {
+  dirty = true;
+  if (level)
+    level->markChanged(position);
+}
+
+ViewObject& Square::modViewObject() {
+  setDirty();
+  return Renderable::modViewObject();
+}
+
+void Square::setViewObject(const ViewObject& obj) {
+  if (obj != getViewObject()) {
+    setDirty();
+    Renderable::setViewObject(obj);
+  }
+}
+
 void Square::setNonDirty() {
   dirty = false;
 }
@@ -480,5 +513,7 @@ bool Square::isDirty() const {
 
 void Square::setMovementType(MovementType t) {
   movementType = t;
+  if (level)
+    level->updatePathCaches(position);
 }
 
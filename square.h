@@ -51,8 +51,9 @@ class Square : public Renderable {
   };
   Square(const ViewObject&, Params);
 
-  /** For displaying progress while loading/saving the game.*/
-  static ProgressMeter* progressMeter;
+  /** For displaying progress while loading/saving the game. It's set by the main thread and read by the
+      thread that saves the game.*/
+  static atomic<ProgressMeter*> progressMeter;
 
   /** Returns the square name. */
   string getName() const;
@@ -202,6 +203,8 @@ class Square : public Renderable {
   virtual bool itemBounces(Item* item, Vision*) const;
   void onItemLands(vector<PItem> item, const Attack& attack, int remainingDist, Vec2 dir, Vision*);
   vector<Item*> getItems(function<bool (Item*)> predicate = alwaysTrue<Item*>()) const;
+  /** Returns the items without copying them, so the square mustn't change while they are iterated.*/
+  const vector<Item*>& getAllItems() const;
   PItem removeItem(Item*);
   vector<PItem> removeItems(vector<Item*>);
 
@@ -231,9 +234,15 @@ class Square : public Renderable {
   string SERIAL(name);
   const MovementType& getMovementType() const;
   void setMovementType(MovementType);
+  /** Marks the square as changed, so only call it to actually modify the object.*/
+  virtual ViewObject& modViewObject() override;
+  /** Marks the square as changed if \paramname{obj} looks different from the current object.*/
+  virtual void setViewObject(const ViewObject& obj) override;
 
   private:
   Item* getTopItem() const;
+  /** Marks the square for updating the viewers' memory and in the level's change journal.*/
+  void setDirty();
 
   Level* SERIAL2(level, nullptr);
   Vec2 SERIAL(position);
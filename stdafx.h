@@ -36,6 +36,8 @@
 #include <stack>
 #include <stdexcept>
 #include <tuple>
+#include <bitset>
+#include <list>
 
 // Use boost threads on OSX to use the main thread for rendering
 // and set a large stack size for the model thread.
@@ -342,8 +342,8 @@ static Vec2 chooseRandomClose(Vec2 start, const vector<Vec2>& squares) {
 
 class BringItem : public PickItem {
   public:
-  BringItem(Callback* c, Vec2 position, vector<Item*> items, vector<Vec2> _target)
-      : PickItem(c, position, items), target(chooseRandomClose(position, _target)) {}
+  BringItem(Callback* c, Vec2 position, vector<Item*> items, Vec2 _target, vector<SquareType> _destination = {})
+      : PickItem(c, position, items), target(_target), destination(_destination) {}
 
   virtual CreatureAction getBroughtAction(Creature* c, vector<Item*> it) {
     return c->drop(it);
@@ -368,6 +368,9 @@ class BringItem : public PickItem {
         if (Creature* other = c->getLevel()->getSafeSquare(target)->getCreature())
           if (other->isAffected(LastingEffect::SLEEP))
             other->removeEffect(LastingEffect::SLEEP);
+      if (!destination.empty())
+        if (const DestinationArea* area = callback->getDestinationArea(destination))
+          return c->moveTowardsShared(target, *area);
       return c->moveTowards(target);
     }
   }
@@ -379,7 +382,8 @@ class BringItem : public PickItem {
   template <class Archive> 
   void serialize(Archive& ar, const unsigned int version) {
     ar& SUBCLASS(PickItem)
-      & SVAR(target);
+      & SVAR(target)
+      & SVAR(destination);
     CHECK_SERIAL;
   }
   
@@ -387,16 +391,19 @@ class BringItem : public PickItem {
 
   protected:
   Vec2 SERIAL(target);
+  vector<SquareType> SERIAL(destination);
 };
 
-PTask Task::bringItem(Callback* c, Vec2 position, vector<Item*> items, vector<Vec2> target) {
-  return PTask(new BringItem(c, position, items, target));
+PTask Task::bringItem(Callback* c, Vec2 position, vector<Item*> items, vector<SquareType> destination) {
+  const DestinationArea* area = NOTNULL(c->getDestinationArea(destination));
+  CHECK(!area->getSquares().empty());
+  return PTask(new BringItem(c, position, items, chooseRandomClose(position, area->getSquares()), destination));
 }
 
 class ApplyItem : public BringItem {
   public:
   ApplyItem(Callback* c, Vec2 position, vector<Item*> items, Vec2 _target) 
-      : BringItem(c, position, items, {_target}), callback(c) {}
+      : BringItem(c, position, items, _target), callback(c) {}
 
   virtual void cancel() override {
     callback->onAppliedItemCancel(target);
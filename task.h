@@ -21,6 +21,8 @@
 #include "entity_set.h"
 #include "square_type.h"
 
+class DestinationArea;
+
 class Task : public UniqueEntity<Task> {
   public:
 
@@ -37,6 +39,8 @@ class Task : public UniqueEntity<Task> {
     virtual void onBedCreated(Vec2 pos, SquareType fromType, SquareType toType) {}
     virtual void onCopulated(Creature* who, Creature* with) {}
     virtual void onConsumed(Creature* consumer, Creature* who) {}
+    /** Returns the squares of the given types that items are brought to, if the callback keeps them.*/
+    virtual const DestinationArea* getDestinationArea(const vector<SquareType>&) { return nullptr; }
 
     SERIALIZATION_DECL(Callback);
   };
@@ -52,7 +56,7 @@ class Task : public UniqueEntity<Task> {
 
   static PTask construction(Callback*, Vec2 target, SquareType);
   static PTask buildTorch(Callback*, Vec2 target, Dir attachmentDir);
-  static PTask bringItem(Callback*, Vec2 position, vector<Item*>, vector<Vec2> target);
+  static PTask bringItem(Callback*, Vec2 position, vector<Item*>, vector<SquareType> destination);
   static PTask applyItem(Callback*, Vec2 position, Item* item, Vec2 target);
   static PTask applySquare(Callback*, vector<Vec2> squares);
   static PTask pickAndEquipItem(Callback*, Vec2 position, Item* item);
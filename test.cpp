@@ -21,34 +21,135 @@
 #include "level_maker.h"
 #include "test.h"
 #include "sectors.h"
+#include "visibility_map.h"
+#include "field_of_view.h"
+#include "bucket_map.h"
+#include "map_memory.h"
+#include "view_object.h"
+#include "view_id.h"
+#include "item.h"
+#include "item_factory.h"
+#include "flow_field.h"
+#include "path_graph.h"
+#include "creature.h"
+#include "time_queue.h"
+#include "controller.h"
+#include "model.h"
+#include "game_info.h"
+#include "level.h"
+#include "vision.h"
+#include "progress_meter.h"
+#include "monster_ai.h"
+
+#ifdef COUNT_ALLOCATIONS
+/** Counts allocations made by the current thread, so tests can check that a code path doesn't allocate.
+    Only the binary built with 'make test' replaces operator new, the game doesn't.*/
+static thread_local int numAllocations = 0;
+
+void* operator new(size_t size) {
+  ++numAllocations;
+  if (void* ret = malloc(size))
+    return ret;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  free(ptr);
+}
+#endif
 
 void testStringConvertion() {
   CHECK(toString(1234) == "1234");
   CHECK(fromString<int>("1234") == 1234);
 }
 
+static PCreature makeTestCreature() {
+  return PCreature(new Creature(nullptr, CATTR(
+        c.viewId = ViewId::JACKAL;
+        c.attr[AttrType::SPEED] = 100;
+        c.attr[AttrType::STRENGTH] = 1;
+        c.attr[AttrType::DEXTERITY] = 1;
+        c.size = CreatureSize::SMALL;
+        c.weight = 1;
+        c.humanoid = false;
+        c.name = "jackal";),
+      ControllerFactory([](Creature* c) { return new DoNothingController(c); })));
+}
+
 void testTimeQueue() {
- /* CreatureAttributes attr = CATTR(c.name = ""; c.speed = 5; c.size = CreatureSize::SMALL; c.strength = 1; c.dexterity = 3; c.humanoid = false; c.weight = 0.1;);
-  PCreature b(new Creature(ViewObject(ViewId::JACKAL, ViewLayer::CREATURE, ""), nullptr, attr));
-  PCreature a(new Creature(ViewObject(ViewId::PLAYER, ViewLayer::CREATURE, ""), nullptr, attr));
-  PCreature c(new Creature(ViewObject(ViewId::JACKAL, ViewLayer::CREATURE, ""), nullptr, attr));
-  Creature* rb = b.get(), *ra = a.get(), *rc = c.get();
+  PCreature a = makeTestCreature();
+  PCreature b = makeTestCreature();
+  PCreature c = makeTestCreature();
+  Creature* ra = a.get(), *rb = b.get(), *rc = c.get();
   a->setTime(1);
   b->setTime(1.33);
   c->setTime(1.66);
   TimeQueue q;
+  q.addCreature(move(c));
   q.addCreature(move(a));
   q.addCreature(move(b));
-  q.addCreature(move(c));
   CHECK(q.getNextCreature() == ra);
   ra->setTime(2);
   CHECK(q.getNextCreature() == rb);
   rb->setTime(2);
   CHECK(q.getNextCreature() == rc);
   rc->setTime(3);
+  // Equal times are ordered by creation, regardless of the order of updates.
+  CHECK(q.getNextCreature() == ra);
+  ra->setTime(3);
   CHECK(q.getNextCreature() == rb);
   rb->setTime(3);
-  CHECK(q.getNextCreature() == ra);*/
+  CHECK(q.getNextCreature() == ra);
+  // Moving a creature back in time brings it to the front.
+  rc->setTime(2.5);
+  CHECK(q.getNextCreature() == rc);
+  CHECKEQ(q.getCurrentTime(), 2.5);
+  CHECK(q.removeCreature(rb).get() == rb);
+  CHECK(q.getNextCreature() == rc);
+  q.removeCreature(rc);
+  CHECK(q.getNextCreature() == ra);
+  CHECKEQ(int(q.getAllCreatures().size()), 1);
+}
+
+void testTimeQueueRemove() {
+  vector<Creature*> all;
+  TimeQueue q;
+  for (int i : Range(50)) {
+    PCreature c = makeTestCreature();
+    c->setTime((i * 17) % 23);
+    all.push_back(c.get());
+    q.addCreature(move(c));
+  }
+  vector<PCreature> removed;
+  // Remove creatures from the middle of the heap and shift a few others.
+  for (int i = 0; i < all.size(); i += 3)
+    removed.push_back(q.removeCreature(all[i]));
+  for (int i = 1; i < all.size(); i += 7)
+    if (i % 3 != 0)
+      all[i]->setTime(all[i]->getTime() + 11.5);
+  vector<Creature*> left;
+  for (int i : All(all))
+    if (i % 3 != 0)
+      left.push_back(all[i]);
+  CHECKEQ(int(q.getAllCreatures().size()), int(left.size()));
+  vector<Creature*> order;
+  double lastTime = -1;
+  while (order.size() < left.size()) {
+    Creature* next = q.getNextCreature();
+    for (Creature* c : order)
+      CHECK(c != next);
+    CHECK(lastTime < next->getTime() || (lastTime == next->getTime()
+          && order.back()->getUniqueId() < next->getUniqueId()));
+    lastTime = next->getTime();
+    order.push_back(next);
+    next->setTime(1000);
+  }
+  CHECK(q.getNextCreature() == left[0]);
+  // Removed creatures can be added to another queue.
+  TimeQueue q2;
+  for (PCreature& c : removed)
+    q2.addCreature(move(c));
+  CHECK(q2.getNextCreature() == all[0]);
 }
 
 void testRectangleIterator() {
@@ -114,6 +215,16 @@ void testAStar() {
       Vec2::directions4(), Vec2(4, 0), Vec2(0, 0));
 }
 
+void testDijkstra() {
+  vector<vector<double> > table { { 1, 1, 1}, { 1, 5, 1}, {1, 1, 1}};
+  Dijkstra dijkstra(Rectangle(3, 3), Vec2(0, 0), 2,
+      [table](Vec2 pos) { return table[pos.y][pos.x];}, Vec2::directions4());
+  CHECKEQ(dijkstra.getDist(Vec2(2, 0)), 2);
+  CHECKEQ(dijkstra.getDist(Vec2(0, 2)), 2);
+  CHECK(!dijkstra.isReachable(Vec2(1, 1)));
+  CHECK(!dijkstra.isReachable(Vec2(2, 2)));
+}
+
 void testShortestPath2() {
   vector<vector<double> > table { { 2, 1, 2, ShortestPath::infinity, 1}, { 1, 1, 18, 1, ShortestPath::infinity}, {2, 6, 10, 1,1}, {1, 2, 1, 8, 1}, {5, 3, 1, 1, 2}};
   ShortestPath path(Rectangle(5, 5),
@@ -137,6 +248,114 @@ void testShortestPathReverse() {
   CHECK(res == expected);*/
 }
 
+void testFlowField() {
+  double inf = ShortestPath::infinity;
+  vector<vector<double>> table {
+      {1, 1, inf, 1, 1},
+      {1, 1, 100, 1, 1},
+      {1, 1, 1, 1, 1}};
+  FlowField field(Rectangle(5, 3), {Vec2(4, 0)}, [&table] (Vec2 pos) { return table[pos.y][pos.x]; });
+  CHECKEQ(field.getDistance(Vec2(4, 0)), 0);
+  CHECKEQ(field.getDistance(Vec2(3, 1)), 1);
+  CHECKEQ(field.getDistance(Vec2(1, 1)), 3);
+  // The square costing 100 is closer to the target, but it's cheaper to go around it.
+  vector<Vec2> moves = field.getNextMoves(Vec2(1, 1));
+  CHECKEQ(int(moves.size()), 2);
+  CHECK(moves[0] == Vec2(2, 2));
+  CHECK(moves[1] == Vec2(2, 1));
+  CHECK(field.getNextMoves(Vec2(4, 0)).empty());
+  FlowField field2(Rectangle(5, 3), {Vec2(0, 0), Vec2(4, 0)},
+      [&table] (Vec2 pos) { return table[pos.y][pos.x]; });
+  CHECKEQ(field2.getDistance(Vec2(1, 2)), 2);
+  CHECKEQ(field2.getDistance(Vec2(3, 2)), 2);
+  table[1][2] = table[2][2] = inf;
+  FlowField field3(Rectangle(5, 3), {Vec2(4, 0)}, [&table] (Vec2 pos) { return table[pos.y][pos.x]; });
+  CHECK(!field3.isReachable(Vec2(0, 0)));
+  CHECK(field3.getNextMoves(Vec2(0, 0)).empty());
+}
+
+void testFlowFieldCache() {
+  vector<vector<double>> table(10, vector<double>(10, 1));
+  int numCalls = 0;
+  auto entryFun = [&] (Vec2 pos) { ++numCalls; return table[pos.y][pos.x]; };
+  FlowFieldCache cache;
+  DestinationArea target({Vec2(0, 0)});
+  CHECKEQ(cache.get(target, MovementType(), Rectangle(10, 10), entryFun).getDistance(Vec2(2, 2)), 2);
+  // A change outside of the explored part keeps the field.
+  cache.squareChanged(Vec2(9, 9));
+  int lastCalls = numCalls;
+  CHECKEQ(cache.get(target, MovementType(), Rectangle(10, 10), entryFun).getDistance(Vec2(2, 2)), 2);
+  CHECKEQ(numCalls, lastCalls);
+  table[1][1] = ShortestPath::infinity;
+  cache.squareChanged(Vec2(1, 1));
+  CHECKEQ(cache.get(target, MovementType(), Rectangle(10, 10), entryFun).getDistance(Vec2(2, 2)), 3);
+  CHECK(numCalls > lastCalls);
+  // Fields are kept by area id, an area with new squares gets a field of its own.
+  DestinationArea moved({Vec2(0, 0), Vec2(3, 3)});
+  CHECK(moved.getId() != target.getId());
+  CHECKEQ(cache.get(moved, MovementType(), Rectangle(10, 10), entryFun).getDistance(Vec2(2, 2)), 1);
+  CHECKEQ(cache.get(target, MovementType(), Rectangle(10, 10), entryFun).getDistance(Vec2(2, 2)), 3);
+}
+
+/** Walks from \paramname{from} to \paramname{to} planning the path again at every waypoint, like a creature
+    does. The path must never end anywhere else. Returns the number of steps or -1 if the target wasn't
+    reached.*/
+static int walkHierarchical(Rectangle bounds, function<double(Vec2)> entryFun, PathGraph& graph, Vec2 from,
+    Vec2 to) {
+  Vec2 pos = from;
+  int steps = 0;
+  while (pos != to && steps < bounds.getW() * bounds.getH()) {
+    ShortestPath path(bounds, entryFun, graph, to, pos);
+    if (!path.isReachable(pos))
+      return -1;
+    while (pos != to && !path.reachedPartialEnd(pos)) {
+      CHECK(path.isReachable(pos)) << "Path ended at " << pos;
+      pos = path.getNextMove(pos);
+      ++steps;
+    }
+  }
+  return pos == to ? steps : -1;
+}
+
+void testPathGraph() {
+  Rectangle bounds(100, 50);
+  Table<bool> wall(bounds, false);
+  // Walls with narrow gaps across the whole level, and a closed room.
+  for (int x : {20, 40, 60, 80})
+    for (int y : Range(50))
+      if (abs(y - (x * 7) % 45 - 2) > 1)
+        wall[Vec2(x, y)] = true;
+  for (int x : Range(30))
+    if (x != 5)
+      wall[Vec2(x, 25)] = true;
+  for (Vec2 v : Rectangle(44, 29, 51, 36))
+    if (!v.inRectangle(Rectangle(45, 30, 50, 35)))
+      wall[v] = true;
+  function<double(Vec2)> entryFun = [&wall] (Vec2 pos) { return wall[pos] ? ShortestPath::infinity : 1.0; };
+  PathGraph graph(bounds, [&wall] (Vec2 pos) { return !wall[pos]; });
+  vector<Vec2> squares {Vec2(2, 2), Vec2(97, 47), Vec2(47, 32), Vec2(10, 40), Vec2(70, 5), Vec2(55, 45),
+      Vec2(35, 2), Vec2(99, 0)};
+  for (Vec2 from : squares) {
+    Dijkstra flat(bounds, from, 100000, entryFun);
+    for (Vec2 to : squares)
+      if (from != to) {
+        int steps = walkHierarchical(bounds, entryFun, graph, from, to);
+        CHECKEQ(int(steps > -1), int(flat.isReachable(to)));
+        CHECKEQ(int(graph.isConnected(from, to)), int(flat.isReachable(to)));
+        if (steps > -1)
+          CHECK(steps <= flat.getDist(to) * 1.5 + PathGraph::chunkSize) << from << " " << to << " " << steps
+              << " " << flat.getDist(to);
+      }
+  }
+  // Closing a gap disconnects the right part of the level.
+  for (int y : Range(50))
+    wall[Vec2(80, y)] = true;
+  for (int y : Range(50))
+    graph.squareChanged(Vec2(80, y));
+  CHECK(!graph.isConnected(Vec2(2, 2), Vec2(97, 47)));
+  CHECKEQ(walkHierarchical(bounds, entryFun, graph, Vec2(2, 2), Vec2(97, 47)), -1);
+}
+
 void testRandom() {
   CHECK(chooseRandom<string>({"pokpok", "kwakwa", "pikpik"}, { 1, 2, 3}, 1) == "pokpok");
   CHECK(chooseRandom<string>({"pokpok", "kwakwa", "pikpik"}, { 1, 2, 3}, 2) == "kwakwa");
@@ -347,6 +566,29 @@ void testTransform2() {
   CHECKEQ(res, s);
 }
 
+void testRunInParallel() {
+  vector<int> first(100, -1);
+  runInParallel(5, first.size(), [&](int index, RandomGen& random) { first[index] = random.get(1000000); });
+  vector<int> second(100, -1);
+  runInParallel(5, second.size(), [&](int index, RandomGen& random) { second[index] = random.get(1000000); });
+  CHECKEQ(first, second);
+  CHECK(first[0] != first[1]);
+  // Nested calls run on the calling thread and give the same results.
+  vector<vector<int>> nested(3, vector<int>(100, -1));
+  runInParallel(1, nested.size(), [&](int i, RandomGen&) {
+      runInParallel(5, nested[i].size(), [&](int index, RandomGen& random) {
+          nested[i][index] = random.get(1000000); });});
+  for (auto& elem : nested)
+    CHECKEQ(elem, first);
+  bool thrown = false;
+  try {
+    runInParallel(0, 10, [&](int index, RandomGen&) { if (index == 7) throw string("job failed"); });
+  } catch (string s) {
+    thrown = true;
+  }
+  CHECK(thrown);
+}
+
 void testSectors1() {
   Sectors sectors(Rectangle(7, 7));
   sectors.add(Vec2(0, 0));
@@ -386,6 +628,562 @@ void testSectors2() {
   CHECK(!s.same(Vec2(0, 3), Vec2(3, 2)));
 }
 
+/** Replays a keeper digging tunnels and putting up walls in a cave, and checks the sectors against
+    a flood fill.*/
+void testSectorsDigSequence() {
+  Rectangle bounds(60, 60);
+  Table<bool> passable(bounds, false);
+  Sectors s(bounds);
+  auto sameReference = [&](Vec2 from, Vec2 to) {
+    if (!passable[from] || !passable[to])
+      return false;
+    Table<bool> visited(bounds, false);
+    queue<Vec2> q;
+    q.push(from);
+    visited[from] = true;
+    while (!q.empty()) {
+      Vec2 pos = q.front();
+      q.pop();
+      if (pos == to)
+        return true;
+      for (Vec2 v : pos.neighbors8())
+        if (v.inRectangle(bounds) && passable[v] && !visited[v]) {
+          visited[v] = true;
+          q.push(v);
+        }
+    }
+    return false;
+  };
+  RandomGen random;
+  random.init(123);
+  for (Vec2 v : Rectangle(15, 15, 45, 45))
+    if (!random.roll(8)) {
+      passable[v] = true;
+      s.add(v);
+    }
+  Vec2 digger(30, 30);
+  MEASURE(
+    for (int i : Range(3000)) {
+      digger = digger + Vec2(random.get(-1, 2), random.get(-1, 2));
+      if (!digger.inRectangle(bounds.minusMargin(1)))
+        digger = Vec2(30, 30);
+      if ((passable[digger] = !random.roll(3)))
+        s.add(digger);
+      else
+        s.remove(digger);
+      if (i % 100 == 0)
+        for (int j : Range(10)) {
+          Vec2 v(random.get(bounds.getW()), random.get(bounds.getH()));
+          Vec2 w(random.get(bounds.getW()), random.get(bounds.getH()));
+          CHECK(s.same(v, w) == sameReference(v, w)) << v << " " << w;
+        }
+    }, "sectors dig sequence");
+}
+
+void testVisibilityMap() {
+  VisibilityMap m(Rectangle(5, 5));
+  m.updateEyeball(Vec2(0, 0), {Vec2(0, 0), Vec2(1, 1)});
+  m.updateEyeball(Vec2(2, 2), {Vec2(2, 2), Vec2(1, 1)});
+  CHECK(m.isVisible(Vec2(0, 0)));
+  CHECK(m.isVisible(Vec2(1, 1)));
+  CHECK(!m.isVisible(Vec2(3, 3)));
+  m.popChangedTiles();
+  m.updateEyeball(Vec2(2, 2), {Vec2(2, 2), Vec2(3, 3)});
+  CHECK(m.isVisible(Vec2(1, 1)));
+  CHECK(m.isVisible(Vec2(3, 3)));
+  CHECK(m.popChangedTiles() == vector<Vec2>({Vec2(3, 3)}));
+  m.removeEyeball(Vec2(0, 0));
+  CHECK(!m.isVisible(Vec2(0, 0)));
+  CHECK(!m.isVisible(Vec2(1, 1)));
+  CHECK(m.isVisible(Vec2(2, 2)));
+  CHECK(!m.isVisible(Vec2(10, 10)));
+}
+
+/** Compares the visible squares with the output of the original shadowcasting code.*/
+void testFieldOfViewGolden() {
+  vector<string> map {
+    "#########################",
+    "#.......#...............#",
+    "#.......#....#..........#",
+    "#...........###.........#",
+    "#.......#....#.....#....#",
+    "#####.###..........#....#",
+    "#...........#...........#",
+    "#....#..........#####...#",
+    "#...........#...........#",
+    "#.......#...............#",
+    "#########################"};
+  vector<string> expected {
+    "        ######           ",
+    "        #....            ",
+    "       .#....            ",
+    "        ....##           ",
+    "        #....#.....#     ",
+    "        #..........#     ",
+    "      ......#...........#",
+    "     #.......     ###...#",
+    "    ........#.           ",
+    "  ......#....            ",
+    "  ##### #####            "};
+  Table<bool> opaque(map[0].size(), map.size());
+  for (Vec2 v : opaque.getBounds())
+    opaque[v] = map[v.y][v.x] == '#';
+  FieldOfView fov(opaque);
+  vector<string> result(map.size(), string(map[0].size(), ' '));
+  for (Vec2 v : fov.getVisibleTiles(Vec2(10, 5)))
+    result[v.y][v.x] = map[v.y][v.x];
+  for (int y : All(map))
+    CHECKEQ(result[y], expected[y]);
+  CHECK(fov.canSee(Vec2(10, 5), Vec2(23, 6)));
+  CHECK(!fov.canSee(Vec2(10, 5), Vec2(23, 4)));
+}
+
+/** Computes visibility from every square of a random cave, with a cache too small to keep the results.*/
+void testFieldOfViewCaves() {
+  RandomGen random;
+  random.init(123);
+  Table<bool> opaque(150, 150);
+  for (Vec2 v : opaque.getBounds())
+    opaque[v] = random.roll(4);
+  FieldOfView fov(opaque, 1000);
+  FieldOfView reference(opaque, 100 * 1024 * 1024);
+  auto sorted = [](vector<Vec2> v) { sort(v.begin(), v.end()); return v; };
+  MEASURE(
+    for (Vec2 v : opaque.getBounds().minusMargin(20)) {
+      vector<Vec2> tiles = sorted(fov.getVisibleTiles(v));
+      CHECK(tiles == sorted(reference.getVisibleTiles(v))) << "Different tiles visible from " << v;
+      for (Vec2 w : Rectangle(v - Vec2(3, 3), v + Vec2(4, 4)))
+        CHECKEQ(int(fov.canSee(v, w)), int(std::binary_search(tiles.begin(), tiles.end(), w)));
+    }
+    , "field of view caves");
+  CHECK(fov.getCacheStats().evictions > 0);
+  CHECK(reference.getCacheStats().evictions == 0);
+}
+
+void testBucketMap() {
+  vector<PCreature> creatures;
+  for (int i : Range(4))
+    creatures.push_back(makeTestCreature());
+  Creature* c1 = creatures[0].get(), *c2 = creatures[1].get(), *c3 = creatures[2].get(),
+      *c4 = creatures[3].get();
+  BucketMap<Creature*> m(100, 100, 30);
+  m.addElement(Vec2(5, 5), c1);
+  m.addElement(Vec2(6, 6), c2);
+  m.addElement(Vec2(40, 40), c3);
+  m.addElement(Vec2(99, 99), c4);
+  CHECKEQ((int) m.getElements(Rectangle(100, 100)).size(), 4);
+  CHECK(m.getElements(Rectangle(0, 0, 6, 6)) == vector<Creature*>({c1}));
+  m.removeElement(Vec2(5, 5), c1);
+  CHECK(m.getElements(Rectangle(0, 0, 30, 30)) == vector<Creature*>({c2}));
+  m.moveElement(Vec2(6, 6), Vec2(38, 38), c2);
+  auto all = [](Creature*) { return true; };
+  CHECK(m.getNearest(Vec2(37, 37), 10, 2, all) == vector<Creature*>({c2, c3}));
+  CHECK(m.getNearest(Vec2(37, 37), 10, 2, [&](Creature* c) { return c != c2; }) == vector<Creature*>({c3}));
+  CHECK(m.getNearest(Vec2(37, 37), 1, 2, all) == vector<Creature*>({c2}));
+  CHECK(m.getNearest(Vec2(31, 31), 70, 1, all) == vector<Creature*>({c2}));
+  CHECK(m.getNearest(Vec2(98, 98), 70, 3, all) == vector<Creature*>({c4, c3, c2}));
+  int count = 0;
+  m.visit(Rectangle(30, 30, 100, 100), [&count] (Creature*) { ++count; });
+  CHECKEQ(count, 3);
+}
+
+/** Compares BucketMap::getNearest with sorting all elements by distance, and checks that the predicate isn't
+    evaluated on elements farther than the result.*/
+void testBucketMapNearest() {
+  RandomGen random;
+  random.init(4);
+  vector<PCreature> creatures;
+  map<Creature*, Vec2> positions;
+  BucketMap<Creature*> m(120, 90, 30);
+  for (int i : Range(60)) {
+    creatures.push_back(makeTestCreature());
+    Vec2 pos(random.get(120), random.get(90));
+    positions[creatures.back().get()] = pos;
+    m.addElement(pos, creatures.back().get());
+  }
+  for (int i : Range(200)) {
+    Vec2 center(random.get(120), random.get(90));
+    int maxDist = random.get(1, 50);
+    int num = random.get(1, 4);
+    // Every third creature doesn't match, like an invisible or friendly one would.
+    auto matches = [&](Creature* c) { return c->getUniqueId() % 3 != 0; };
+    int maxChecked = 0;
+    vector<Creature*> result = m.getNearest(center, maxDist, num, [&](Creature* c) {
+        maxChecked = max(maxChecked, (positions.at(c) - center).length8());
+        return matches(c);});
+    vector<int> expected;
+    for (auto& elem : positions)
+      if ((elem.second - center).length8() <= maxDist && matches(elem.first))
+        expected.push_back((elem.second - center).length8());
+    sort(expected.begin(), expected.end());
+    expected.resize(min<int>(expected.size(), num));
+    CHECKEQ(int(result.size()), int(expected.size()));
+    for (int j : All(result))
+      CHECKEQ((positions.at(result[j]) - center).length8(), expected[j]);
+    if (result.size() == num)
+      CHECK(maxChecked <= expected.back());
+  }
+}
+
+static bool sameAreas(const vector<Rectangle>& v1, const vector<Rectangle>& v2) {
+  if (v1.size() != v2.size())
+    return false;
+  for (int i : All(v1))
+    if (v1[i].getTopLeft() != v2[i].getTopLeft() || v1[i].getBottomRight() != v2[i].getBottomRight())
+      return false;
+  return true;
+}
+
+void testChangeJournal() {
+  ChangeJournal journal(5);
+  int reader, lateReader;
+  // The first call only registers the reader.
+  CHECK(!journal.getSince(&reader));
+  CHECK(journal.getSince(&reader)->empty());
+  journal.add(Rectangle(1, 1));
+  journal.add(Rectangle(2, 2));
+  CHECK(!journal.getSince(&lateReader));
+  CHECK(sameAreas(*journal.getSince(&reader), {Rectangle(1, 1), Rectangle(2, 2)}));
+  CHECK(journal.getSince(&reader)->empty());
+  journal.add(Rectangle(3, 3));
+  CHECK(sameAreas(*journal.getSince(&reader), {Rectangle(3, 3)}));
+  // Entries are kept until the last reader has them.
+  CHECK(sameAreas(*journal.getSince(&lateReader), {Rectangle(3, 3)}));
+  for (int i : Range(4, 9))
+    journal.add(Rectangle(i, i));
+  CHECKEQ((int) journal.getSince(&reader)->size(), 5);
+  // The sixth unread entry drops the reader that is furthest behind, but keeps the others' entries.
+  journal.add(Rectangle(9, 9));
+  CHECK(sameAreas(*journal.getSince(&reader), {Rectangle(9, 9)}));
+  CHECK(!journal.getSince(&lateReader));
+  journal.add(Rectangle(10, 10));
+  CHECK(sameAreas(*journal.getSince(&lateReader), {Rectangle(10, 10)}));
+}
+
+/** Fills the journal of the default length, which is what Level uses.*/
+void testChangeJournalTruncation() {
+  ChangeJournal journal;
+  int reader, behind;
+  journal.getSince(&reader);
+  journal.getSince(&behind);
+  for (int i : Range(10000)) {
+    journal.add(Rectangle(Vec2(i, 0), Vec2(i + 1, 1)));
+    CHECKEQ((int) journal.getSince(&reader)->size(), 1);
+  }
+  CHECKEQ((int) journal.getSince(&behind)->size(), 10000);
+  for (int i : Range(10001)) {
+    journal.add(Rectangle(Vec2(i, 0), Vec2(i + 1, 1)));
+    CHECKEQ((int) journal.getSince(&reader)->size(), 1);
+  }
+  CHECK(!journal.getSince(&behind));
+}
+
+void testMapMemory() {
+  MapMemory memory;
+  CHECK(!memory.hasViewIndex(Vec2(700, 700)));
+  memory.addObject(Vec2(700, 700), ViewObject(ViewId::WALL, ViewLayer::FLOOR, "Wall"));
+  ViewIndex index;
+  index.insert(ViewObject(ViewId::FLOOR, ViewLayer::FLOOR, "Floor"));
+  index.insert(ViewObject(ViewId::PLAYER, ViewLayer::CREATURE, "Player"));
+  memory.update(Vec2(3, 4), index);
+  CHECK(memory.hasViewIndex(Vec2(700, 700)));
+  ViewIndex remembered;
+  memory.mergeInto(Vec2(3, 4), remembered);
+  CHECK(remembered.hasObject(ViewLayer::FLOOR));
+  CHECK(!remembered.hasObject(ViewLayer::CREATURE));
+  CHECK(remembered.getHighlight(HighlightType::MEMORY) > 0);
+  // A visible creature over a remembered square only gets the floor filled in.
+  remembered.clear();
+  remembered.insert(ViewObject(ViewId::PLAYER, ViewLayer::CREATURE, "Player"));
+  memory.mergeInto(Vec2(3, 4), remembered);
+  CHECK(remembered.hasObject(ViewLayer::FLOOR));
+  CHECK(remembered.getObject(ViewLayer::CREATURE).id() == ViewId::PLAYER);
+  CHECK(remembered.getHighlight(HighlightType::MEMORY) == 0);
+  memory.clearSquare(Vec2(700, 700));
+  CHECK(!memory.hasViewIndex(Vec2(700, 700)));
+  // Squares that look the same share their objects, so filling the rest of the chunk costs nothing.
+  size_t usage = memory.getMemoryUsage();
+  for (Vec2 v : Rectangle(16, 16))
+    memory.update(v, index);
+  CHECKEQ((int) memory.getMemoryUsage(), (int) usage);
+  index.setHighlight(HighlightType::NIGHT, 0.5);
+  memory.update(Vec2(5, 5), index);
+  std::stringstream stream;
+  {
+    OutputArchive output(stream);
+    output << BOOST_SERIALIZATION_NVP(memory);
+  }
+  MapMemory loaded;
+  InputArchive input(stream);
+  input >> BOOST_SERIALIZATION_NVP(loaded);
+  for (Vec2 v : Rectangle(16, 16))
+    CHECK(loaded.hasViewIndex(v));
+  CHECK(!loaded.hasViewIndex(Vec2(16, 16)));
+  remembered.clear();
+  loaded.mergeInto(Vec2(5, 5), remembered);
+  CHECK(remembered.getObject(ViewLayer::FLOOR).id() == ViewId::FLOOR);
+  CHECK(fabs(remembered.getHighlight(HighlightType::NIGHT) - 0.5) < 0.01);
+  CHECKEQ((int) loaded.getMemoryUsage(), (int) memory.getMemoryUsage());
+}
+
+class TestLevelMaker : public LevelMaker {
+  public:
+  virtual void make(Level::Builder* builder, Rectangle area) override {
+    RandomGen random;
+    random.init(12);
+    // Like the real levels, it's closed by a wall, so sight never leaves it.
+    for (Vec2 v : area)
+      builder->putSquare(v, random.roll(6) || !v.inRectangle(area.minusMargin(1))
+          ? SquareId::BLACK_WALL : SquareId::FLOOR);
+    for (Vec2 v : {Vec2(5, 5), Vec2(20, 12), Vec2(33, 30)})
+      builder->putSquare(v, SquareId::TORCH);
+  }
+};
+
+/** The caches of a level aren't saved, so after loading they must be rebuilt to the same state.*/
+void testLevelSerialization() {
+  Vision::init();
+  Model model;
+  ProgressMeter meter(1);
+  TestLevelMaker maker;
+  PLevel level = Level::Builder(meter, 40, 40, "Test").build(&model, &maker);
+  Table<double> light(level->getBounds());
+  for (Vec2 v : level->getBounds())
+    light[v] = level->getLight(v);
+  CHECK(light[Vec2(5, 5)] > 0);
+  vector<Vec2> viewers {Vec2(6, 5), Vec2(20, 20), Vec2(30, 31)};
+  vector<vector<Vec2>> visible;
+  for (Vec2 v : viewers)
+    visible.push_back(level->getVisibleTiles(v, Vision::get(VisionId::NORMAL)));
+  std::stringstream stream;
+  {
+    OutputArchive output(stream);
+    Serialization::registerTypes(output);
+    output << BOOST_SERIALIZATION_NVP(level);
+  }
+  PLevel loaded;
+  {
+    InputArchive input(stream);
+    Serialization::registerTypes(input);
+    MEASURE(input >> BOOST_SERIALIZATION_NVP(loaded), "level loading time");
+  }
+  for (Vec2 v : loaded->getBounds())
+    CHECKEQ(loaded->getLight(v), light[v]);
+  // Loading replaced the vision singletons, so the ones the loaded squares use are looked up again.
+  for (int i : All(viewers))
+    CHECK(loaded->getVisibleTiles(viewers[i], Vision::get(VisionId::NORMAL)) == visible[i])
+      << "Different tiles visible from " << viewers[i];
+  delete loaded->getModel();
+  loaded.reset();
+  level.reset();
+  Vision::clearAll();
+}
+
+void testTripleBuffer() {
+  TripleBuffer<int> buffer;
+  CHECK(buffer.wasRead());
+  CHECK(!buffer.read());
+  buffer.getWriteBuffer() = 1;
+  buffer.publish();
+  CHECK(!buffer.wasRead());
+  buffer.getWriteBuffer() = 2;
+  buffer.publish();
+  CHECKEQ(*buffer.read(), 2);
+  CHECK(buffer.wasRead());
+  CHECK(!buffer.read());
+  const int num = 100000;
+  thread writer([&] {
+    for (int i : Range(num)) {
+      buffer.getWriteBuffer() = i;
+      buffer.publish();
+    }
+  });
+  int last = -1;
+  while (last < num - 1)
+    if (int* value = buffer.read()) {
+      CHECK(*value > last);
+      last = *value;
+    }
+  writer.join();
+}
+
+/** The minion list is kept between frames and is rebuilt when its hash changes, so the hash has to cover
+    everything it draws.*/
+void testMinionListHash() {
+  PCreature creature = makeTestCreature();
+  GameInfo::BandInfo info;
+  info.newTeam = false;
+  info.minions.push_back(GameInfo::CreatureInfo(creature.get()));
+  info.teams[0] = {creature->getUniqueId()};
+  auto getHash = [&] {
+    info.updateHashes();
+    return info.minionsHash;
+  };
+  size_t hash = getHash();
+  CHECK(getHash() == hash);
+  info.minions[0].viewObject.setAttribute(ViewObject::Attribute::BLEEDING, 0.5);
+  CHECK(getHash() != hash);
+  hash = info.minionsHash;
+  info.minions[0].viewObject.setModifier(ViewObject::Modifier::POISONED);
+  CHECK(getHash() != hash);
+  hash = info.minionsHash;
+  ++info.minions[0].expLevel;
+  CHECK(getHash() != hash);
+  hash = info.minionsHash;
+  info.currentTeam = 0;
+  CHECK(getHash() != hash);
+  hash = info.minionsHash;
+  info.newTeam = true;
+  CHECK(getHash() != hash);
+}
+
+void testItemStacks() {
+  vector<PItem> items;
+  for (ItemId id : {ItemId::ROCK, ItemId::GOLD_PIECE, ItemId::ROCK, ItemId::IRON_ORE, ItemId::GOLD_PIECE,
+      ItemId::ROCK})
+    items.push_back(ItemFactory::fromId(id));
+  vector<Item*> refs = extractRefs(items);
+  ItemStacks stacks;
+  stacks.reset(refs);
+  CHECKEQ(stacks.getNumStacks(), (int) Item::stackItems(refs).size());
+  vector<int> sizes;
+  for (int i : Range(stacks.getNumStacks())) {
+    sizes.push_back(stacks.getSize(i));
+    for (Item* item : stacks.getItems(i))
+      CHECKEQ(item->getNameAndModifiers(), stacks.getFirst(i)->getNameAndModifiers());
+  }
+  std::sort(sizes.begin(), sizes.end());
+  CHECKEQ(sizes, vector<int>({1, 2, 3}));
+  // Resetting with fewer items must not leave anything from the previous grouping.
+  stacks.reset({refs[1], refs[3], refs[4]});
+  CHECKEQ(stacks.getNumStacks(), 2);
+  double totalWeight = 0;
+  int totalSize = 0;
+  for (int i : Range(stacks.getNumStacks())) {
+    totalWeight += stacks.getWeight(i);
+    totalSize += stacks.getSize(i);
+    CHECKEQ((int) stacks.getItems(i).size(), stacks.getSize(i));
+  }
+  CHECKEQ(totalSize, 3);
+  CHECK(fabs(totalWeight - refs[1]->getWeight() - refs[3]->getWeight() - refs[4]->getWeight()) < 1e-9);
+  stacks.reset({});
+  CHECKEQ(stacks.getNumStacks(), 0);
+#ifdef COUNT_ALLOCATIONS
+  stacks.reset(refs);
+  int allocations = numAllocations;
+  stacks.reset(refs);
+  for (int i : Range(stacks.getNumStacks()))
+    stacks.getWeight(i);
+  // CHECKEQ builds its message first, so the count is taken before.
+  allocations = numAllocations - allocations;
+  CHECKEQ(allocations, 0);
+#endif
+}
+
+/** Once its scratch space has grown, MonsterAI::makeMove of a creature with nothing to pick up
+    allocates nothing.*/
+void testMonsterAIAllocations() {
+#ifdef COUNT_ALLOCATIONS
+  LogLevel previousLevel = Log::getLevel();
+  Log::setLevel("warning");
+  PCreature creature = makeTestCreature();
+  PMonsterAI ai = MonsterAIFactory::idle().getMonsterAI(creature.get());
+  for (int i : Range(3))
+    ai->makeMove();
+  int allocations = numAllocations;
+  for (int i : Range(100))
+    ai->makeMove();
+  allocations = numAllocations - allocations;
+  CHECKEQ(allocations, 0);
+  Log::setLevel(Log::getName(previousLevel));
+#endif
+}
+
+class FloorLevelMaker : public LevelMaker {
+  public:
+  virtual void make(Level::Builder* builder, Rectangle area) override {
+    for (Vec2 v : area)
+      builder->putSquare(v, SquareId::FLOOR);
+  }
+};
+
+/** A humanoid standing on weapons, which its Fighter behaviour values less than waiting, goes through all
+    the pick up options on every move without picking anything up. The behaviours allocate when they look
+    around, so the allocations are compared with the same creature standing on an empty square.*/
+void testMonsterAIPickUpAllocations() {
+#ifdef COUNT_ALLOCATIONS
+  LogLevel previousLevel = Log::getLevel();
+  Log::setLevel("warning");
+  Vision::init();
+  Skill::init();
+  Tribe::init();
+  {
+    Model model;
+    ProgressMeter meter(1);
+    FloorLevelMaker maker;
+    PLevel level = Level::Builder(meter, 30, 10, "Test").build(&model, &maker);
+    vector<Creature*> creatures;
+    vector<PMonsterAI> ais;
+    for (Vec2 pos : {Vec2(5, 5), Vec2(25, 5)}) {
+      PCreature creature(new Creature(Tribe::get(TribeId::MONSTER), CATTR(
+            c.viewId = ViewId::BANDIT;
+            c.attr[AttrType::SPEED] = 100;
+            c.attr[AttrType::STRENGTH] = 30;
+            c.attr[AttrType::DEXTERITY] = 10;
+            c.size = CreatureSize::LARGE;
+            c.weight = 70;
+            c.humanoid = true;
+            c.name = "bandit";),
+          ControllerFactory([](Creature* c) { return new DoNothingController(c); })));
+      creatures.push_back(creature.get());
+      ais.push_back(MonsterAIFactory::stayInLocation(nullptr, false).getMonsterAI(creature.get()));
+      level->addCreature(pos, std::move(creature));
+    }
+    Square* stacks = level->getSafeSquare(creatures[0]->getPosition());
+    for (ItemType type : {ItemId::KNIFE, ItemId::CLUB, ItemId::SPEAR})
+      stacks->dropItems(ItemFactory::fromId(type, 3));
+    vector<int> allocations;
+    for (PMonsterAI& ai : ais) {
+      for (int i : Range(3))
+        ai->makeMove();
+      int before = numAllocations;
+      for (int i : Range(100))
+        ai->makeMove();
+      allocations.push_back(numAllocations - before);
+    }
+    CHECKEQ(allocations[0], allocations[1]);
+    CHECK(creatures[0]->getEquipment().isEmpty());
+    CHECKEQ((int) stacks->getItems().size(), 9);
+  }
+  Tribe::clearAll();
+  Skill::clearAll();
+  Vision::clearAll();
+  Log::setLevel(Log::getName(previousLevel));
+#endif
+}
+
+/** Logs to a file of its own, and puts back the log file and level the tests were run with.*/
+void testLog() {
+  LogLevel previousLevel = Log::getLevel();
+  string previousPath = Log::getPath();
+  string path = "test_log.tmp";
+  Log::init(path);
+  int numEvaluated = 0;
+  Log::setLevel("warning");
+  LOG(INFO, GENERAL) << ++numEvaluated;
+  LOG(WARNING, PATH) << "test record " << ++numEvaluated;
+  Log::setLevel(Log::getName(previousLevel));
+  Log::flush();
+  std::stringstream printed;
+  Log::print(path, printed);
+  Log::init(previousPath, true);
+  remove(path.c_str());
+  CHECKEQ(numEvaluated, 1);
+  CHECK(Log::getLevel() == previousLevel);
+  CHECK(printed.str().find("WARNING PATH test.cpp") != string::npos);
+  CHECK(printed.str().find("test record 1") != string::npos);
+}
+
 void testReverse() {
   vector<int> v1 {1, 2, 3, 4};
   vector<int> v2 {4, 3, 2, 1};
@@ -408,13 +1206,18 @@ int testAll() {
   Debug::init();
   testStringConvertion();
   testTimeQueue();
+  testTimeQueueRemove();
   testRectangleIterator();
   testValueCheck();
   testSplit();
   testShortestPath();
   testAStar();
+  testDijkstra();
   testShortestPath2();
   testShortestPathReverse();
+  testFlowField();
+  testFlowFieldCache();
+  testPathGraph();
   testRandom();
   testRange();
   testContains();
@@ -432,11 +1235,28 @@ int testAll() {
   testVec2Box0();
   testVec2Box1();
   testVec2Box2();
+  testRunInParallel();
   testSectors1();
   testSectors2();
+  testSectorsDigSequence();
+  testVisibilityMap();
+  testFieldOfViewGolden();
+  testFieldOfViewCaves();
+  testBucketMap();
+  testBucketMapNearest();
+  testChangeJournal();
+  testChangeJournalTruncation();
+  testMapMemory();
+  testLevelSerialization();
+  testTripleBuffer();
+  testMinionListHash();
+  testItemStacks();
+  testMonsterAIAllocations();
+  testMonsterAIPickUpAllocations();
+  testLog();
   testReverse();
   testReverse2();
   testReverse3();
-  Debug() << "-----===== OK =====-----";
+  LOG(INFO, GENERAL) << "-----===== OK =====-----";
   return 0;
 }
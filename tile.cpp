@@ -149,7 +149,7 @@ class TileCoordLookup {
     bool bad = false;
     for (ViewId id : ENUM_ALL(ViewId))
       if (!tiles.count(id)) {
-        Debug() << "ViewId not found: " << EnumInfo<ViewId>::getString(id);
+        LOG(WARNING, GUI) << "ViewId not found: " << EnumInfo<ViewId>::getString(id);
         bad = true;
       }
     CHECK(!bad);
@@ -160,7 +160,7 @@ class TileCoordLookup {
     bool bad = false;
     for (ViewId id : ENUM_ALL(ViewId))
       if (!symbols.count(id)) {
-        Debug() << "ViewId not found: " << EnumInfo<ViewId>::getString(id);
+        LOG(WARNING, GUI) << "ViewId not found: " << EnumInfo<ViewId>::getString(id);
         bad = true;
       }
     CHECK(!bad);
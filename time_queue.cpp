@@ -21,9 +21,14 @@
 template <class Archive> 
 void TimeQueue::serialize(Archive& ar, const unsigned int version) { 
   ar& SVAR(creatures)
-    & SVAR(queue)
-    & SVAR(dead);
+    & SVAR(numAdded)
+    & SVAR(heap);
   CHECK_SERIAL;
+  if (Archive::is_loading::value)
+    for (int i : All(heap)) {
+      heapIndex[heap[i].id] = i;
+      heap[i].creature->timeQueue = this;
+    }
 }
 
 SERIALIZABLE(TimeQueue);
@@ -32,70 +37,109 @@ SERIALIZABLE(TimeQueue);
 template <class Archive> 
 void TimeQueue::QElem::serialize(Archive& ar, const unsigned int version) {
   ar& BOOST_SERIALIZATION_NVP(creature)
-    & BOOST_SERIALIZATION_NVP(time);
+    & BOOST_SERIALIZATION_NVP(time)
+    & BOOST_SERIALIZATION_NVP(id)
+    & BOOST_SERIALIZATION_NVP(order);
 }
 
 SERIALIZABLE(TimeQueue::QElem);
 
-TimeQueue::TimeQueue() : queue([](QElem e1, QElem e2) {
-    return e1.time > e2.time || (e1.time == e2.time && e1.creature->getUniqueId() > e2.creature->getUniqueId());
-}) {
+TimeQueue::TimeQueue() {
+}
+
+bool TimeQueue::isBefore(const QElem& e1, const QElem& e2) const {
+  return e1.time < e2.time || (e1.time == e2.time && e1.id < e2.id);
+}
+
+const int heapArity = 4;
+
+void TimeQueue::set(int index, const QElem& elem) {
+  heap[index] = elem;
+  heapIndex[elem.id] = index;
+}
+
+void TimeQueue::siftUp(int index) {
+  QElem elem = heap[index];
+  while (index > 0) {
+    int parent = (index - 1) / heapArity;
+    if (!isBefore(elem, heap[parent]))
+      break;
+    set(index, heap[parent]);
+    index = parent;
+  }
+  set(index, elem);
+}
+
+void TimeQueue::siftDown(int index) {
+  QElem elem = heap[index];
+  while (1) {
+    int best = -1;
+    for (int child = heapArity * index + 1; child <= heapArity * index + heapArity && child < heap.size();
+        ++child)
+      if (best == -1 || isBefore(heap[child], heap[best]))
+        best = child;
+    if (best == -1 || !isBefore(heap[best], elem))
+      break;
+    set(index, heap[best]);
+    index = best;
+  }
+  set(index, elem);
+}
+
+void TimeQueue::removeFromHeap(int index) {
+  heapIndex.erase(heap[index].id);
+  QElem last = heap.back();
+  heap.pop_back();
+  if (index < heap.size()) {
+    set(index, last);
+    siftUp(index);
+    siftDown(heapIndex.at(last.id));
+  }
 }
 
 void TimeQueue::addCreature(PCreature c) {
-  queue.push({c.get(), c->getTime()});
-  creatures.push_back(std::move(c));
+  CHECK(!c->timeQueue);
+  c->timeQueue = this;
+  heap.push_back({c.get(), c->getTime(), c->getUniqueId(), numAdded});
+  siftUp(heap.size() - 1);
+  creatures[numAdded++] = std::move(c);
 }
   
 PCreature TimeQueue::removeCreature(Creature* cRef) {
-  int ind = -1;
-  for (int i : All(creatures))
-    if (creatures[i].get() == cRef) {
-      ind = i;
-      break;
-    }
-  CHECK(ind > -1) << "Creature not found";
-  PCreature ret = std::move(creatures[ind]);
-  creatures.erase(creatures.begin() + ind);
-  dead.insert(ret.get());
+  CHECK(heapIndex.count(cRef->getUniqueId())) << "Creature not found";
+  int index = heapIndex.at(cRef->getUniqueId());
+  int order = heap[index].order;
+  removeFromHeap(index);
+  PCreature ret = std::move(creatures.at(order));
+  creatures.erase(order);
+  ret->timeQueue = nullptr;
   return ret;
 }
 
+void TimeQueue::updateTime(Creature* c) {
+  int index = heapIndex.at(c->getUniqueId());
+  if (heap[index].time == c->getTime())
+    return;
+  heap[index].time = c->getTime();
+  siftUp(index);
+  siftDown(heapIndex.at(c->getUniqueId()));
+}
+
 vector<Creature*> TimeQueue::getAllCreatures() const {
   vector<Creature*> ret;
-  for (const PCreature& c : creatures)
-    ret.push_back(c.get());
+  for (auto& elem : creatures)
+    ret.push_back(elem.second.get());
   return ret;
 }
 
-void TimeQueue::removeDead() {
-  while (!queue.empty() && dead.count(queue.top().creature))
-    queue.pop();
-}
-
-Creature* TimeQueue::getMinCreature() {
-  CHECK(creatures.size() > 0);
-  removeDead();
-  QElem elem = queue.top();
-  if (elem.time == elem.creature->getTime())
-    return elem.creature;
-  else {
-    queue.pop();
-    removeDead();
-    queue.push({elem.creature, elem.creature->getTime()});
-    CHECK(queue.top().creature->getTime() == queue.top().time);
-    return queue.top().creature;
-  }
-}
-
 Creature* TimeQueue::getNextCreature() {
-  Creature* c = getMinCreature();
-  return c;
+  CHECK(!heap.empty());
+  return heap[0].creature;
 }
 
 double TimeQueue::getCurrentTime() {
-  if (creatures.size() > 0) 
-    return getMinCreature()->getTime();
+  if (!heap.empty()) 
+    return heap[0].time;
   else
     return 0;
 }
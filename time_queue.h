@@ -17,6 +17,7 @@
 #define _TIME_QUEUE_H
 
 #include "util.h"
+#include "unique_entity.h"
 
 class Creature;
 
@@ -29,26 +30,36 @@ class TimeQueue {
   PCreature removeCreature(Creature* c);
   double getCurrentTime();
 
+  /** Moves the creature to its new place in the queue. Called by the creature whenever its time changes.*/
+  void updateTime(Creature*);
+
   template <class Archive> 
   void serialize(Archive& ar, const unsigned int version);
 
   SERIAL_CHECKER;
 
   private:
-  void removeDead();
-  Creature* getMinCreature();
-
-  vector<PCreature> SERIAL(creatures);
-
   struct QElem {
     Creature* creature;
     double time;
+    UniqueEntity<Creature>::Id id;
+    int order;
 
     template <class Archive> 
     void serialize(Archive& ar, const unsigned int version);
   };
-  priority_queue<QElem, vector<QElem>, function<bool(QElem, QElem)>> SERIAL(queue);
-  unordered_set<Creature*> SERIAL(dead);
+  bool isBefore(const QElem&, const QElem&) const;
+  void set(int index, const QElem&);
+  void siftUp(int index);
+  void siftDown(int index);
+  void removeFromHeap(int index);
+
+  /** Creatures in the order they were added, keyed by a counter.*/
+  map<int, PCreature> SERIAL(creatures);
+  int SERIAL2(numAdded, 0);
+  /** Four-ary heap ordered by time and then by unique id.*/
+  vector<QElem> SERIAL(heap);
+  unordered_map<UniqueEntity<Creature>::Id, int> heapIndex;
 };
 
 #endif
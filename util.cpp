@@ -713,6 +713,47 @@ void Semaphore::v() {
 AsyncLoop::AsyncLoop(function<void()> f) : AsyncLoop([]{}, f) {
 }
 
+static thread_local bool insideParallelJob = false;
+
+void runInParallel(int seed, int numJobs, function<void(int, RandomGen&)> job) {
+  atomic<int> nextJob(0);
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  auto worker = [&] {
+    bool wasInside = insideParallelJob;
+    insideParallelJob = true;
+    for (int index = nextJob++; index < numJobs; index = nextJob++) {
+      std::seed_seq seq {seed, index};
+      unsigned jobSeed;
+      seq.generate(&jobSeed, &jobSeed + 1);
+      RandomGen random;
+      random.init(jobSeed);
+      try {
+        job(index, random);
+      } catch (...) {
+        std::unique_lock<std::mutex> lock(errorMutex);
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+    insideParallelJob = wasInside;
+  };
+  // Nested calls run on the calling thread, the outer call already keeps the cores busy.
+  if (numJobs < 2 || insideParallelJob)
+    worker();
+  else {
+    int numThreads = min<int>(numJobs, thread::hardware_concurrency());
+    vector<thread> threads;
+    for (int i = 1; i < numThreads; ++i)
+      threads.emplace_back(worker);
+    worker();
+    for (thread& t : threads)
+      t.join();
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
 AsyncLoop::AsyncLoop(function<void()> init, function<void()> loop)
     : t([=] { init(); while (!done) { loop(); }}), done(false) {
 }
@@ -722,6 +763,45 @@ AsyncLoop::~AsyncLoop() {
   t.join();
 }
 
+ChangeJournal::ChangeJournal(int l) : maxLength(l) {
+}
+
+void ChangeJournal::add(Rectangle area) {
+  // Readers refresh everything on their first call anyway.
+  if (readers.empty())
+    return;
+  changes.push_back(area);
+  if (int(changes.size()) > maxLength) {
+    for (auto it = readers.begin(); it != readers.end();)
+      if (it->second == offset)
+        it = readers.erase(it);
+      else
+        ++it;
+    trim();
+  }
+}
+
+Optional<vector<Rectangle>> ChangeJournal::getSince(const void* reader) {
+  int end = offset + changes.size();
+  auto it = readers.find(reader);
+  if (it == readers.end()) {
+    readers[reader] = end;
+    return Nothing();
+  }
+  vector<Rectangle> ret(changes.begin() + (it->second - offset), changes.end());
+  it->second = end;
+  trim();
+  return ret;
+}
+
+void ChangeJournal::trim() {
+  int oldest = offset + changes.size();
+  for (auto& elem : readers)
+    oldest = min(oldest, elem.second);
+  changes.erase(changes.begin(), changes.begin() + (oldest - offset));
+  offset = oldest;
+}
+
 ConstructorFunction::ConstructorFunction(function<void()> fun) {
   fun();
 }
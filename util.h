@@ -19,6 +19,7 @@
 #include <iostream>
 
 #include "debug.h"
+#include "profiler.h"
 #include "enums.h"
 #include "serialization.h"
 
@@ -171,6 +172,11 @@ template <class T> struct hash<std::set<T>> {
 
 }
 
+template <class T>
+void combineHash(size_t& seed, const T& elem) {
+  seed = seed * 79146198 + hash<T>()(elem);
+}
+
 
 class Rectangle {
   public:
@@ -290,6 +296,13 @@ class RandomGen {
 
 extern RandomGen Random;
 
+/** Runs the jobs on several threads and waits for all of them to finish. Each job gets its own random
+    generator seeded from \paramname{seed} and the job's index, so the results don't depend on scheduling.
+    Jobs must not modify shared state, they should store their results to be merged by the caller in order.
+    The threads are started and joined on every call, so it's only worth it for coarse one-off work such as
+    level generation, not for anything done every turn.*/
+void runInParallel(int seed, int numJobs, function<void(int, RandomGen&)> job);
+
 inline Debug& operator <<(Debug& d, Rectangle rect) {
   return d << "(" << rect.getPX() << "," << rect.getPY() << ") (" << rect.getKX() << "," << rect.getKY() << ")";
 }
@@ -841,8 +854,12 @@ vector<T> concat(const vector<vector<T>>& vectors) {
   return ret;
 }
 
-template<class T>
-inline T& operator <<(T& d, Vec2 msg) {
+// Not a template over the stream type, because that would also catch boost archives and write Vec2 as text.
+inline std::ostream& operator <<(std::ostream& d, Vec2 msg) {
+  return d << "(" << msg.x << "," << msg.y << ")";
+}
+
+inline Debug& operator <<(Debug& d, Vec2 msg) {
   return d << "(" << msg.x << "," << msg.y << ")";
 }
 
@@ -1345,6 +1362,41 @@ class SyncQueue {
   queue<T> q;
 };
 
+/** Passes values from one writer thread to one reader thread without locking. The writer fills its
+    buffer and publishes it, the reader picks up the newest published buffer. Neither side ever waits.*/
+template <class T>
+class TripleBuffer {
+  public:
+  T& getWriteBuffer() {
+    return buffers[writeIndex];
+  }
+
+  /** Swaps in the write buffer, dropping the previous published value if it wasn't read yet.*/
+  void publish() {
+    writeIndex = middle.exchange(writeIndex | fresh) & ~fresh;
+  }
+
+  /** True if the reader has picked up the last published value, or nothing was published yet.*/
+  bool wasRead() const {
+    return !(middle & fresh);
+  }
+
+  /** Returns the newest published value, or null if there is nothing new since the last call.*/
+  T* read() {
+    if (wasRead())
+      return nullptr;
+    readIndex = middle.exchange(readIndex) & ~fresh;
+    return &buffers[readIndex];
+  }
+
+  private:
+  enum { fresh = 4 };
+  T buffers[3];
+  int writeIndex = 0;
+  int readIndex = 1;
+  std::atomic<int> middle {2};
+};
+
 class AsyncLoop {
   public:
   AsyncLoop(function<void()> init, function<void()> loop);
@@ -1356,6 +1408,28 @@ class AsyncLoop {
   std::atomic<bool> done;
 };
 
+/** Journal of changed areas. The journal keeps a position for each reader and drops the entries that
+    all of them have read. If it still grows too long, the readers furthest behind are dropped.*/
+class ChangeJournal {
+  public:
+  ChangeJournal(int maxLength = 10000);
+
+  void add(Rectangle area);
+
+  /** Returns the areas added since the previous call by \paramname{reader} and moves it to the end
+      of the journal. Returns Nothing on the first call and after the reader was dropped, the reader
+      should refresh everything then.*/
+  Optional<vector<Rectangle>> getSince(const void* reader);
+
+  private:
+  void trim();
+  int maxLength;
+  deque<Rectangle> changes;
+  /** Number of entries dropped from the front.*/
+  int offset = 0;
+  unordered_map<const void*, int> readers;
+};
+
 template <typename T, typename... Args>
 function<void(Args...)> bindMethod(void (T::*ptr) (Args...), T* t) {
   return [=](Args... a) { (t->*ptr)(a...);};
@@ -78,3 +78,76 @@ GameInfo::CreatureInfo& GameInfo::BandInfo::getMinion(UniqueEntity<Creature>::Id
   return minions[0];
 }
 
+/** Covers everything the renderer may draw from a ViewObject, as GuiElem::viewObject keeps a copy of
+    the whole object.*/
+static void combineHash(size_t& seed, const ViewObject& obj) {
+  combineHash(seed, obj.id());
+  for (auto modifier : ENUM_ALL(ViewObject::Modifier))
+    combineHash(seed, obj.hasModifier(modifier));
+  for (auto attribute : ENUM_ALL(ViewObject::Attribute))
+    combineHash(seed, obj.getAttribute(attribute));
+}
+
+static void combineHash(size_t& seed, const GameInfo::CreatureInfo& info) {
+  combineHash(seed, info.viewObject);
+  combineHash(seed, info.uniqueId);
+  combineHash(seed, info.speciesName);
+  combineHash(seed, info.expLevel);
+}
+
+static size_t getHash(const vector<GameInfo::BandInfo::Button>& buttons) {
+  size_t ret = buttons.size();
+  for (auto& elem : buttons) {
+    combineHash(ret, elem.object);
+    combineHash(ret, elem.name);
+    combineHash(ret, bool(elem.cost));
+    if (elem.cost) {
+      combineHash(ret, elem.cost->first);
+      combineHash(ret, elem.cost->second);
+    }
+    combineHash(ret, elem.count);
+    combineHash(ret, elem.inactiveReason);
+    combineHash(ret, elem.help);
+    combineHash(ret, elem.hotkey);
+    combineHash(ret, elem.groupName);
+  }
+  return ret;
+}
+
+void GameInfo::BandInfo::updateHashes() {
+  minionsHash = minions.size();
+  combineHash(minionsHash, monsterHeader);
+  for (auto& elem : minions)
+    combineHash(minionsHash, elem);
+  combineHash(minionsHash, teams.size());
+  for (auto& team : teams) {
+    combineHash(minionsHash, team.first);
+    combineHash(minionsHash, team.second.size());
+    for (auto id : team.second)
+      combineHash(minionsHash, id);
+  }
+  combineHash(minionsHash, currentTeam.getOr(-1));
+  combineHash(minionsHash, newTeam);
+  buildingsHash = getHash(buildings);
+  technologyHash = getHash(libraryButtons);
+  for (auto& elem : techButtons) {
+    combineHash(technologyHash, elem.viewId);
+    combineHash(technologyHash, elem.name);
+    combineHash(technologyHash, elem.hotkey);
+  }
+  deitiesHash = deities.size();
+  for (auto& elem : deities) {
+    combineHash(deitiesHash, elem.name);
+    combineHash(deitiesHash, elem.standing);
+  }
+}
+
+void GameInfo::VillageInfo::updateHash() {
+  hash = villages.size();
+  for (auto& elem : villages) {
+    combineHash(hash, elem.name);
+    combineHash(hash, elem.tribeName);
+    combineHash(hash, elem.state);
+  }
+}
+
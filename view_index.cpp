@@ -63,6 +63,15 @@ bool ViewIndex::noObjects() const {
   return objects.empty();
 }
 
+void ViewIndex::clear() {
+  std::fill(objIndex.begin(), objIndex.end(), -1);
+  objects.clear();
+  for (HighlightType h : ENUM_ALL(HighlightType))
+    highlight[h] = 0;
+  anyHighlight = false;
+  hiddenId = Nothing();
+}
+
 const ViewObject& ViewIndex::getObject(ViewLayer l) const {
   int ind = objIndex[int(l)];
   CHECK(ind >= 0 && ind < objects.size()) << "No object on layer " << int(l) << " " << ind;
@@ -100,15 +109,3 @@ Optional<ViewId> ViewIndex::getHiddenId() const {
 void ViewIndex::setHiddenId(ViewId id) {
   hiddenId = id;
 }
-
-void ViewIndex::mergeFromMemory(const ViewIndex& memory) {
-  if (isEmpty())
-    *this = memory;
-  else if (!hasObject(ViewLayer::FLOOR) && !hasObject(ViewLayer::FLOOR_BACKGROUND) && !isEmpty()) {
-    // special case when monster or item is visible but floor is only in memory
-    if (memory.hasObject(ViewLayer::FLOOR))
-      insert(memory.getObject(ViewLayer::FLOOR));
-    if (memory.hasObject(ViewLayer::FLOOR_BACKGROUND))
-      insert(memory.getObject(ViewLayer::FLOOR_BACKGROUND));
-  }
-}
@@ -42,9 +42,10 @@ class ViewIndex {
   const ViewObject& getObject(ViewLayer) const;
   ViewObject& getObject(ViewLayer);
   const ViewObject* getTopObject(const vector<ViewLayer>&) const;
-  void mergeFromMemory(const ViewIndex& memory);
   bool isEmpty() const;
   bool noObjects() const;
+  /** Removes all objects and highlights, keeping the allocated memory for reuse.*/
+  void clear();
   ~ViewIndex();
   // If the tile is not visible, we still need the id of the floor tile to render connections properly.
   Optional<ViewId> getHiddenId() const;
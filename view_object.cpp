@@ -49,6 +49,28 @@ ViewObject::ViewObject(ViewId id, ViewLayer l, const string& d)
     setAttribute(attr, -1);
 }
 
+bool ViewObject::operator == (const ViewObject& o) const {
+  return enemyStatus == o.enemyStatus && modifiers == o.modifiers && attributes == o.attributes
+      && resource_id == o.resource_id && viewLayer == o.viewLayer && description == o.description
+      && bool(attachmentDir) == bool(o.attachmentDir) && (!attachmentDir || *attachmentDir == *o.attachmentDir);
+}
+
+bool ViewObject::operator != (const ViewObject& o) const {
+  return !(*this == o);
+}
+
+size_t hash<ViewObject>::operator()(const ViewObject& obj) const {
+  size_t ret = 0;
+  combineHash(ret, int(obj.id()));
+  combineHash(ret, int(obj.layer()));
+  combineHash(ret, obj.getBareDescription());
+  for (auto modifier : ENUM_ALL(ViewObject::Modifier))
+    combineHash(ret, obj.hasModifier(modifier));
+  for (auto attribute : ENUM_ALL(ViewObject::Attribute))
+    combineHash(ret, obj.getAttribute(attribute));
+  return ret;
+}
+
 void ViewObject::setCreatureId(UniqueEntity<Creature>::Id id) {
   creatureId = id;
 }
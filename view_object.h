@@ -41,6 +41,10 @@ class ViewObject {
   typedef ViewObjectAttribute Attribute;
   ViewObject(ViewId id, ViewLayer l, const string& description);
 
+  /** Compares how the objects look, ignoring their position, creature id and movement.*/
+  bool operator == (const ViewObject&) const;
+  bool operator != (const ViewObject&) const;
+
   enum EnemyStatus { HOSTILE, FRIENDLY, UNKNOWN };
   void setEnemyStatus(EnemyStatus);
   bool isHostile() const;
@@ -114,4 +118,11 @@ class ViewObject {
   } movementQueue;
 };
 
+namespace std {
+  /** Consistent with ViewObject::operator ==, which ignores position, creature id and movement.*/
+  template <> struct hash<ViewObject> {
+    size_t operator()(const ViewObject&) const;
+  };
+}
+
 #endif
@@ -48,7 +48,7 @@ void VillageControl::onKillEvent(const Creature* victim, const Creature* killer)
 }
 
 void VillageControl::launchAttack(Villain& villain, vector<Creature*> attackers) {
-  Debug() << getAttackMessage(villain, attackers);
+  LOG(INFO, COLLECTIVE) << getAttackMessage(villain, attackers);
   villain.collective->addAssaultNotification(getCollective(), attackers, getAttackMessage(villain, attackers));
   getCollective()->getTeams().activate(getCollective()->getTeams().create(attackers));
   for (Creature* c : attackers)
@@ -58,7 +58,7 @@ void VillageControl::launchAttack(Villain& villain, vector<Creature*> attackers)
 void VillageControl::tick(double time) {
   vector<Creature*> fighters = getCollective()->getCreatures({MinionTrait::FIGHTER}, {MinionTrait::LEADER});
   vector<Creature*> allMembers = getCollective()->getCreatures();
-  Debug() << getCollective()->getName() << " fighters: " << int(fighters.size())
+  LOG(INFO, COLLECTIVE) << getCollective()->getName() << " fighters: " << int(fighters.size())
     << (!getCollective()->getTeams().getAll().empty() ? " attacking " : "");
   for (auto team : getCollective()->getTeams().getAll()) {
     for (const Creature* c : getCollective()->getTeams().getMembers(team))
@@ -185,7 +185,7 @@ double VillageControl::Villain::getAttackProbability(const VillageControl* self)
     double val = getTriggerValue(elem, self, collective);
     CHECK(val >= 0 && val <= 1);
     ret = max(ret, val);
-    Debug() << "trigger " << int(elem.getId()) << " village " << self->getCollective()->getTribe()->getName()
+    LOG(INFO, COLLECTIVE) << "trigger " << int(elem.getId()) << " village " << self->getCollective()->getTribe()->getName()
       << " under attack probability " << val;
   }
   return ret;
@@ -0,0 +1,90 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+#include "visibility_map.h"
+#include "creature.h"
+
+template <class Archive>
+void VisibilityMap::serialize(Archive& ar, const unsigned int version) {
+  ar& SVAR(lastUpdates)
+    & SVAR(eyeballs)
+    & SVAR(visibilityCount);
+  CHECK_SERIAL;
+}
+
+SERIALIZABLE(VisibilityMap);
+
+SERIALIZATION_CONSTRUCTOR_IMPL(VisibilityMap);
+
+VisibilityMap::VisibilityMap(Rectangle bounds) : visibilityCount(bounds, 0) {
+}
+
+void VisibilityMap::addTiles(const vector<Vec2>& tiles) {
+  for (Vec2 v : tiles)
+    if (v.inRectangle(visibilityCount.getBounds()))
+      if (++visibilityCount[v] == 1)
+        changedTiles.push_back(v);
+}
+
+void VisibilityMap::removeTiles(const vector<Vec2>& tiles) {
+  for (Vec2 v : tiles)
+    if (v.inRectangle(visibilityCount.getBounds())) {
+      if (--visibilityCount[v] == 0)
+        changedTiles.push_back(v);
+      CHECK(visibilityCount[v] >= 0);
+    }
+}
+
+void VisibilityMap::update(const Creature* c, const vector<Vec2>& visibleTiles) {
+  // Adding before removing leaves the tiles seen both times out of the changed tiles.
+  addTiles(visibleTiles);
+  remove(c);
+  lastUpdates[c] = visibleTiles;
+}
+
+void VisibilityMap::remove(const Creature* c) {
+  if (lastUpdates.count(c)) {
+    removeTiles(lastUpdates.at(c));
+    lastUpdates.erase(c);
+  }
+}
+
+void VisibilityMap::updateEyeball(Vec2 pos, const vector<Vec2>& visibleTiles) {
+  addTiles(visibleTiles);
+  removeEyeball(pos);
+  eyeballs[pos] = visibleTiles;
+}
+
+void VisibilityMap::removeEyeball(Vec2 pos) {
+  if (eyeballs.count(pos)) {
+    removeTiles(eyeballs.at(pos));
+    eyeballs.erase(pos);
+  }
+}
+
+vector<Vec2> VisibilityMap::getEyeballs() const {
+  return getKeys(eyeballs);
+}
+
+bool VisibilityMap::isVisible(Vec2 pos) const {
+  return pos.inRectangle(visibilityCount.getBounds()) && visibilityCount[pos] > 0;
+}
+
+vector<Vec2> VisibilityMap::popChangedTiles() {
+  vector<Vec2> ret;
+  ret.swap(changedTiles);
+  return ret;
+}
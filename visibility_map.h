@@ -0,0 +1,47 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+#ifndef _VISIBILITY_MAP_H
+#define _VISIBILITY_MAP_H
+
+#include "util.h"
+
+class Creature;
+
+/** Keeps a count of how many creatures and eyeballs see each tile of a level,
+    so that checking if a tile is visible doesn't require scanning all of them.*/
+class VisibilityMap {
+  public:
+  VisibilityMap(Rectangle bounds);
+  void update(const Creature*, const vector<Vec2>& visibleTiles);
+  void remove(const Creature*);
+  void updateEyeball(Vec2, const vector<Vec2>& visibleTiles);
+  void removeEyeball(Vec2);
+  vector<Vec2> getEyeballs() const;
+  bool isVisible(Vec2) const;
+  /** Returns the tiles that became visible or stopped being visible since the last call.*/
+  vector<Vec2> popChangedTiles();
+
+  SERIALIZATION_DECL(VisibilityMap);
+
+  private:
+  void addTiles(const vector<Vec2>&);
+  void removeTiles(const vector<Vec2>&);
+  map<const Creature*, vector<Vec2>> SERIAL(lastUpdates);
+  map<Vec2, vector<Vec2>> SERIAL(eyeballs);
+  Table<int> SERIAL(visibilityCount);
+  vector<Vec2> changedTiles;
+};
+
+#endif
@@ -134,7 +134,7 @@ void WindowView::initialize() {
   mapGui = new MapGui({
       [this](Vec2 pos) { mapLeftClickFun(pos); },
       [this](Vec2 pos) { mapRightClickFun(pos); },
-      [this] { refreshInput = true;}}, clock );
+      [this] { publishViewArea(); refreshInput = true;}}, clock );
   minimapGui = new MinimapGui([this]() { inputQueue.push(UserInput(UserInputId::DRAW_LEVEL_MAP)); });
   minimapDecoration = GuiElem::border2(GuiElem::rectangle(colors[ColorId::BLACK]));
   resetMapBounds();
@@ -195,7 +195,18 @@ void WindowView::reset() {
   mapLayout = &currentTileLayout.normalLayout;
   gameReady = false;
   mapGui->clearCenter();
+  mapGui->clearObjects();
+  minimapGui->clear();
+  // The gui elements may point into sections cached by the builder.
+  tempGuiElems.clear();
   guiBuilder.reset();
+  // Nothing from before the reset may reach the screen. The render thread only reads snapshots under
+  // the render lock, so it's safe to discard them here.
+  frames.read();
+  frames.getWriteBuffer().clear();
+  framePending = false;
+  viewAreas.read();
+  viewArea = Nothing();
 }
 
 void WindowView::displayOldSplash() {
@@ -262,6 +273,7 @@ void WindowView::clearSplash() {
 
 void WindowView::resize(int width, int height, vector<GuiElem*> gui) {
   renderer.resize(width, height);
+  publishViewArea();
   refreshInput = true;
 }
 
@@ -303,7 +315,6 @@ void WindowView::rebuildGui() {
         break;
   }
   resetMapBounds();
-  CHECK(currentThreadId() != renderThreadId);
   tempGuiElems.clear();
   int bottomOffset = 15;
   int leftMargin = 20;
@@ -362,7 +373,7 @@ void WindowView::rebuildGui() {
     }
     tempGuiElems.push_back(std::move(elem));
     tempGuiElems.back()->setBounds(Rectangle(pos, pos + Vec2(width, height)));
-    Debug() << "Overlay " << overlay.alignment << " bounds " << tempGuiElems.back()->getBounds();
+    LOG(TRACE, GUI) << "Overlay " << overlay.alignment << " bounds " << tempGuiElems.back()->getBounds();
   }
 }
 
@@ -386,7 +397,9 @@ vector<GuiElem*> WindowView::getClickableGuiElems() {
 }
 
 void WindowView::resetCenter() {
-  mapGui->clearCenter();
+  frames.getWriteBuffer().resetCenter = true;
+  viewArea = Nothing();
+  publishFrame();
 }
 
 void WindowView::addVoidDialog(function<void()> fun) {
@@ -407,50 +420,113 @@ void WindowView::drawLevelMap(const CreatureView* creature) {
   TempClockPause pause(clock);
   addVoidDialog([=] {
     minimapGui->presentMap(creature, getMapGuiBounds(), renderer,
-        [this](double x, double y) { mapGui->setCenter(x, y);}); });
+        [this](double x, double y) { mapGui->setCenter(x, y); publishViewArea(); }); });
+}
+
+Rectangle WindowView::getUpdatedTiles(const CreatureView* view) {
+  // Until the render thread reports what it shows, assume a generous area around the default center.
+  Rectangle area = viewArea.getOr(Rectangle(-40, -40, 40, 40));
+  Optional<Vec2> center = view->getPosition(false);
+  if (!center && !viewArea)
+    center = view->getPosition(true);
+  // The render thread will center the map on the creature once it applies the update.
+  if (center)
+    area = area.translate(*center - area.middle());
+  return area;
+}
+
+void WindowView::FrameSnapshot::clear() {
+  hasView = false;
+  map.clear();
+  minimap.clear();
+  animations.clear();
+  resetCenter = false;
+}
+
+void WindowView::publishFrame() {
+  // Overwriting a snapshot that the render thread hasn't read would lose its map changes, so the
+  // write buffer keeps accumulating until then. getAction retries the publishing.
+  framePending = !frames.wasRead();
+  if (!framePending) {
+    frames.publish();
+    frames.getWriteBuffer().clear();
+  }
 }
 
-void WindowView::updateMinimap(const CreatureView* creature) {
-  const Level* level = creature->getLevel();
-  Vec2 rad(40, 40);
-  Rectangle bounds(mapLayout->getPlayerPos() - rad, mapLayout->getPlayerPos() + rad);
-  if (level->getBounds().intersects(bounds))
-    minimapGui->update(level, bounds, creature);
+void WindowView::applyFrame(FrameSnapshot& frame) {
+  PROFILE_ZONE("apply frame");
+  if (frame.resetCenter)
+    mapGui->clearCenter();
+  if (frame.hasView) {
+    gameReady = true;
+    switchTiles();
+    std::swap(gameInfo, frame.gameInfo);
+    mapGui->setSpriteMode(currentTileLayout.sprites);
+    mapGui->applyUpdate(frame.map, mapLayout);
+    minimapGui->applyUpdate(frame.minimap);
+    rebuildGui();
+    publishViewArea();
+  }
+  for (auto& animation : frame.animations)
+    animation();
+}
+
+void WindowView::publishViewArea() {
+  if (!gameReady)
+    return;
+  viewAreas.getWriteBuffer() = mapGui->getVisibleTiles(mapLayout, getMapGuiBounds());
+  viewAreas.publish();
 }
 
 void WindowView::updateView(const CreatureView* collective) {
-  RenderLock lock(renderMutex);
-  updateMinimap(collective);
-  gameReady = true;
-  switchTiles();
-  collective->refreshGameInfo(gameInfo);
-  mapGui->setSpriteMode(currentTileLayout.sprites);
-  mapGui->updateObjects(collective, mapLayout, options->getBoolValue(OptionId::SMOOTH_MOVEMENT));
-  rebuildGui();
+  if (Rectangle* area = viewAreas.read())
+    viewArea = *area;
+  FrameSnapshot& frame = frames.getWriteBuffer();
+  Rectangle tiles = getUpdatedTiles(collective);
+  Vec2 rad(40, 40);
+  minimapGui->update(collective->getLevel(), Rectangle(tiles.middle() - rad, tiles.middle() + rad), collective,
+      frame.minimap);
+  collective->refreshGameInfo(refreshedInfo);
+  frame.gameInfo = refreshedInfo;
+  if (tiles.intersects(Level::getMaxBounds()))
+    tiles = tiles.intersection(Level::getMaxBounds());
+  {
+    PROFILE_ZONE("map update");
+    mapGui->updateObjects(collective, tiles, options->getBoolValue(OptionId::SMOOTH_MOVEMENT), frame.map);
+  }
+  frame.hasView = true;
+  publishFrame();
 }
 
 void WindowView::animateObject(vector<Vec2> trajectory, ViewObject object) {
-  RenderLock lock(renderMutex);
-  if (trajectory.size() >= 2)
-    mapGui->addAnimation(
-        Animation::thrownObject(
-          (trajectory.back() - trajectory.front())
-              .mult(Vec2(mapLayout->squareWidth(), mapLayout->squareHeight())),
-          object,
-          currentTileLayout.sprites),
-        trajectory.front());
+  if (trajectory.size() >= 2) {
+    frames.getWriteBuffer().animations.push_back([=] {
+      mapGui->addAnimation(
+          Animation::thrownObject(
+            (trajectory.back() - trajectory.front())
+                .mult(Vec2(mapLayout->squareWidth(), mapLayout->squareHeight())),
+            object,
+            currentTileLayout.sprites),
+          trajectory.front());
+    });
+    publishFrame();
+  }
 }
 
 void WindowView::animation(Vec2 pos, AnimationId id) {
-  RenderLock lock(renderMutex);
-  if (currentTileLayout.sprites)
-    mapGui->addAnimation(Animation::fromId(id), pos);
+  frames.getWriteBuffer().animations.push_back([=] {
+    if (currentTileLayout.sprites)
+      mapGui->addAnimation(Animation::fromId(id), pos);
+  });
+  publishFrame();
 }
 
 void WindowView::refreshView() {
   {
     RenderLock lock(renderMutex);
     CHECK(currentThreadId() == renderThreadId);
+    if (FrameSnapshot* frame = frames.read())
+      applyFrame(*frame);
     if (gameReady)
       processEvents();
     if (renderDialog) {
@@ -470,6 +546,7 @@ void WindowView::drawMap() {
 }
 
 void WindowView::refreshScreen(bool flipBuffer) {
+  PROFILE_ZONE("refresh screen");
   {
     RenderLock lock(renderMutex);
     if (!gameReady) {
@@ -880,19 +957,21 @@ PGuiElem WindowView::drawListGui(const string& title, const vector<ListElem>& op
 }
 
 void WindowView::switchZoom() {
-  refreshInput = true;
   if (mapLayout != &currentTileLayout.normalLayout)
     mapLayout = &currentTileLayout.normalLayout;
   else
     mapLayout = &currentTileLayout.unzoomLayout;
+  publishViewArea();
+  refreshInput = true;
 }
 
 void WindowView::zoom(bool out) {
-  refreshInput = true;
   if (mapLayout != &currentTileLayout.normalLayout && !out)
     mapLayout = &currentTileLayout.normalLayout;
   else if (out)
     mapLayout = &currentTileLayout.unzoomLayout;
+  publishViewArea();
+  refreshInput = true;
 }
 
 void WindowView::switchTiles() {
@@ -1104,6 +1183,8 @@ void WindowView::keyboardAction(Event::KeyEvent key) {
 }
 
 UserInput WindowView::getAction() {
+  if (framePending)
+    publishFrame();
   lockKeyboard = false;
   if (refreshInput) {
     refreshInput = false;
@@ -1145,7 +1226,7 @@ Optional<Event::KeyEvent> WindowView::getEventFromMenu() {
       View::ListElem("Fire arrows with alt + arrow.", View::TITLE),
       View::ListElem("Choose action:", View::TITLE) };
   for (int i : All(keyInfo)) {
-    Debug() << "Action " << keyInfo[i].action;
+    LOG(INFO, GUI) << "Action " << keyInfo[i].action;
     options.push_back(keyInfo[i].action + "   [ " + keyInfo[i].keyDesc + " ]");
   }
   vector<Event::KeyEvent> shortCuts;
@@ -88,7 +88,7 @@ class WindowView: public View {
   void processEvents();
   void displayMenuSplash2();
   void displayOldSplash();
-  void updateMinimap(const CreatureView*);
+  Rectangle getUpdatedTiles(const CreatureView*);
   void mapLeftClickFun(Vec2);
   void mapRightClickFun(Vec2);
   Rectangle getMenuPosition(View::MenuType type);
@@ -131,6 +131,30 @@ class WindowView: public View {
 
   GameInfo gameInfo;
 
+  /** Everything the render thread needs from one game update. The game thread fills a snapshot and
+      publishes it without ever waiting for the render thread.*/
+  struct FrameSnapshot {
+    bool hasView = false;
+    GameInfo gameInfo;
+    MapGui::Update map;
+    MinimapGui::Update minimap;
+    vector<function<void()>> animations;
+    bool resetCenter = false;
+
+    void clear();
+  };
+  TripleBuffer<FrameSnapshot> frames;
+  /** Set if the write buffer holds data that couldn't be published yet, because the render thread
+      hadn't read the previous snapshot.*/
+  bool framePending = false;
+  void publishFrame();
+  void applyFrame(FrameSnapshot&);
+  GameInfo refreshedInfo;
+  /** Tiles shown by the render thread, reported back to the game thread so it knows what to update.*/
+  TripleBuffer<Rectangle> viewAreas;
+  Optional<Rectangle> viewArea;
+  void publishViewArea();
+
   MapLayout* mapLayout;
   MapGui* mapGui;
   MinimapGui* minimapGui;